@@ -20,6 +20,7 @@
 
 #include "BuffersStorage.hpp"
 
+#include <chrono>
 #include <iomanip>
 #include <vector>
 
@@ -27,12 +28,17 @@
 
 #include <xen/be/Exception.hpp>
 
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+using std::dec;
 using std::hex;
 using std::lock_guard;
 using std::move;
 using std::mutex;
 using std::setfill;
 using std::setw;
+using std::unordered_map;
 
 using XenBackend::XenGnttabBuffer;
 
@@ -44,6 +50,10 @@ using DisplayItf::FrameBufferPtr;
  * BuffersStorage
  ******************************************************************************/
 
+BuffersStorage::Quota BuffersStorage::sLimits {};
+unordered_map<domid_t, BuffersStorage::Quota> BuffersStorage::sUsage;
+mutex BuffersStorage::sUsageMutex;
+
 BuffersStorage::BuffersStorage(domid_t domId, DisplayPtr display) :
 	mDomId(domId),
 	mDisplay(display),
@@ -54,6 +64,13 @@ BuffersStorage::BuffersStorage(domid_t domId, DisplayPtr display) :
 
 BuffersStorage::~BuffersStorage()
 {
+	unreserve({0, 0, mFrameBuffers.size()});
+
+	for (auto& usage : mDisplayBuffersUsage)
+	{
+		unreserve(usage.second);
+	}
+
 	mFrameBuffers.clear();
 
 	mDisplay->flush();
@@ -66,6 +83,35 @@ BuffersStorage::~BuffersStorage()
  * Public
  ******************************************************************************/
 
+void BuffersStorage::setLimits(const Quota& limits)
+{
+	lock_guard<mutex> lock(sUsageMutex);
+
+	sLimits = limits;
+
+	LOG("BuffersStorage", DEBUG) << "Set limits, dumb bytes: "
+								 << sLimits.dumbBytes
+								 << ", grant pages: " << sLimits.grantPages
+								 << ", frame buffers: "
+								 << sLimits.frameBuffers;
+}
+
+void BuffersStorage::dumpStats()
+{
+	lock_guard<mutex> lock(sUsageMutex);
+
+	for (auto& usage : sUsage)
+	{
+		LOG("BuffersStorage", INFO) << "Dom id: " << usage.first
+									<< ", dumb bytes: "
+									<< usage.second.dumbBytes
+									<< ", grant pages: "
+									<< usage.second.grantPages
+									<< ", frame buffers: "
+									<< usage.second.frameBuffers;
+	}
+}
+
 void BuffersStorage::createDisplayBuffer(uint64_t dbCookie, bool beAllocRefs,
 										 grant_ref_t startDirectory,
 										 size_t offset, uint32_t size,
@@ -74,51 +120,31 @@ void BuffersStorage::createDisplayBuffer(uint64_t dbCookie, bool beAllocRefs,
 {
 	lock_guard<mutex> lock(mMutex);
 
-	GrantRefs refs;
-
-	if (!beAllocRefs)
+	if (mDisplayBuffersUsage.count(dbCookie))
 	{
-		pgDirGetBufferRefs(mDomId, startDirectory, size, refs);
+		throw XenBackend::Exception("Display buffer already exists", EEXIST);
 	}
 
-	if (width == 0)
-	{
-		if (beAllocRefs)
-		{
-			throw XenBackend::Exception("Can't create pending display buffer",
-										EINVAL);
-		}
+	// for pending buffer, the dumb is accounted when it is created
 
-		DLOG(mLog, DEBUG) << "Create pending display buffer, start dir: "
-						  << startDirectory
-						  << ", size: " << size << ", offset: " << offset
-						  << ", DB cookie: 0x"
-						  << hex << setfill('0') << setw(16)
-						  << dbCookie;
+	Quota usage {static_cast<size_t>(width) * height * ((bpp + 7) / 8),
+				 (size + XC_PAGE_SIZE - 1) / XC_PAGE_SIZE, 0};
 
-		mPendingDisplayBuffers.emplace(dbCookie, PendingBuffer{offset, refs});
+	reserve(usage);
+
+	try
+	{
+		createDisplayBufferUnlocked(dbCookie, beAllocRefs, startDirectory,
+									offset, size, width, height, bpp);
 	}
-	else
+	catch(const std::exception& e)
 	{
-		DLOG(mLog, DEBUG) << "Create display buffer, w: "
-						  << width << ", h: " << height << ", bpp: " << bpp
-						  << ", offset: " << offset
-						  << ", start dir: " << startDirectory
-						  << ", size: " << size << ", DB cookie: 0x"
-						  << hex << setfill('0') << setw(16)
-						  << dbCookie;
-
-		auto displayBuffer = mDisplay->createDisplayBuffer(width, height, bpp,
-														   offset, mDomId, refs,
-														   beAllocRefs);
-
-		mDisplayBuffers.emplace(dbCookie, displayBuffer);
+		unreserve(usage);
 
-		if (beAllocRefs)
-		{
-			pgDirSetBufferRefs(mDomId, startDirectory, size, refs);
-		}
+		throw;
 	}
+
+	mDisplayBuffersUsage[dbCookie] = usage;
 }
 
 void BuffersStorage::createFrameBuffer(uint64_t dbCookie, uint64_t fbCookie,
@@ -134,12 +160,30 @@ void BuffersStorage::createFrameBuffer(uint64_t dbCookie, uint64_t fbCookie,
 					  << ", DB cookie: " << setw(16) << dbCookie
 					  << ", FB cookie: " << setw(16) << fbCookie;
 
-	handlePendingDisplayBuffers(dbCookie, width, height, pixelFormat);
+	if (mFrameBuffers.count(fbCookie))
+	{
+		throw XenBackend::Exception("Frame buffer already exists", EEXIST);
+	}
+
+	// reserve the FB slot before the pending display buffer gets its dumb
 
-	auto frameBuffer = mDisplay->createFrameBuffer(
-			getDisplayBufferUnlocked(dbCookie), width, height, pixelFormat);
+	reserve({0, 0, 1});
+
+	try
+	{
+		handlePendingDisplayBuffers(dbCookie, width, height, pixelFormat);
 
-	mFrameBuffers.emplace(fbCookie, frameBuffer);
+		auto frameBuffer = mDisplay->createFrameBuffer(
+				getDisplayBufferUnlocked(dbCookie), width, height, pixelFormat);
+
+		mFrameBuffers.emplace(fbCookie, frameBuffer);
+	}
+	catch(const std::exception& e)
+	{
+		unreserve({0, 0, 1});
+
+		throw;
+	}
 }
 
 DisplayBufferPtr BuffersStorage::getDisplayBuffer(uint64_t dbCookie)
@@ -152,6 +196,16 @@ DisplayBufferPtr BuffersStorage::getDisplayBuffer(uint64_t dbCookie)
 	return getDisplayBufferUnlocked(dbCookie);
 }
 
+FrameBufferPtr BuffersStorage::getFrameBuffer(uint64_t fbCookie)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	DLOG(mLog, DEBUG) << "Get frame buffer, FB cookie: 0x"
+					  << hex << setfill('0') << setw(16) << fbCookie;
+
+	return getFrameBufferUnlocked(fbCookie);
+}
+
 FrameBufferPtr BuffersStorage::getFrameBufferAndCopy(uint64_t fbCookie)
 {
 	lock_guard<mutex> lock(mMutex);
@@ -178,6 +232,15 @@ void BuffersStorage::destroyDisplayBuffer(uint64_t dbCookie)
 
 	mDisplayBuffers.erase(dbCookie);
 	mPendingDisplayBuffers.erase(dbCookie);
+
+	auto iter = mDisplayBuffersUsage.find(dbCookie);
+
+	if (iter != mDisplayBuffersUsage.end())
+	{
+		unreserve(iter->second);
+
+		mDisplayBuffersUsage.erase(iter);
+	}
 }
 
 void BuffersStorage::destroyFrameBuffer(uint64_t fbCookie)
@@ -187,13 +250,82 @@ void BuffersStorage::destroyFrameBuffer(uint64_t fbCookie)
 	DLOG(mLog, DEBUG) << "Destroy frame buffer, FB cookie: 0x"
 					  << hex << setfill('0') << setw(16) << fbCookie;
 
-	mFrameBuffers.erase(fbCookie);
+	if (mFrameBuffers.erase(fbCookie))
+	{
+		unreserve({0, 0, 1});
+	}
 }
 
 /*******************************************************************************
  * Private
  ******************************************************************************/
 
+void BuffersStorage::createDisplayBufferUnlocked(uint64_t dbCookie,
+												 bool beAllocRefs,
+												 grant_ref_t startDirectory,
+												 size_t offset, uint32_t size,
+												 uint32_t width,
+												 uint32_t height,
+												 uint32_t bpp)
+{
+	auto start = steady_clock::now();
+
+	GrantRefs refs;
+
+	if (!beAllocRefs)
+	{
+		pgDirGetBufferRefs(mDomId, startDirectory, size, refs);
+	}
+
+	auto walkTime = duration_cast<microseconds>(steady_clock::now() - start);
+
+	if (width == 0)
+	{
+		if (beAllocRefs)
+		{
+			throw XenBackend::Exception("Can't create pending display buffer",
+										EINVAL);
+		}
+
+		DLOG(mLog, DEBUG) << "Create pending display buffer, start dir: "
+						  << startDirectory
+						  << ", size: " << size << ", offset: " << offset
+						  << ", DB cookie: 0x"
+						  << hex << setfill('0') << setw(16)
+						  << dbCookie;
+
+		mPendingDisplayBuffers.emplace(dbCookie, PendingBuffer{offset, refs});
+	}
+	else
+	{
+		DLOG(mLog, DEBUG) << "Create display buffer, w: "
+						  << width << ", h: " << height << ", bpp: " << bpp
+						  << ", offset: " << offset
+						  << ", start dir: " << startDirectory
+						  << ", size: " << size << ", DB cookie: 0x"
+						  << hex << setfill('0') << setw(16)
+						  << dbCookie;
+
+		auto displayBuffer = mDisplay->createDisplayBuffer(width, height, bpp,
+														   offset, mDomId, refs,
+														   beAllocRefs);
+
+		mDisplayBuffers.emplace(dbCookie, displayBuffer);
+
+		if (beAllocRefs)
+		{
+			pgDirSetBufferRefs(mDomId, startDirectory, size, refs);
+		}
+	}
+
+	auto time = duration_cast<microseconds>(steady_clock::now() - start);
+
+	LOG(mLog, DEBUG) << "Create display buffer, size: " << dec << size
+					 << ", refs: " << refs.size()
+					 << ", directory walk: " << walkTime.count() << " us"
+					 << ", total: " << time.count() << " us";
+}
+
 uint32_t BuffersStorage::getBpp(uint32_t format)
 {
 	switch (format)
@@ -259,6 +391,11 @@ void BuffersStorage::handlePendingDisplayBuffers(uint64_t dbCookie,
 	{
 		auto bpp = getBpp(pixelFormat);
 
+		Quota usage {static_cast<size_t>(width) * height * ((bpp + 7) / 8),
+					 0, 0};
+
+		reserve(usage);
+
 		DLOG(mLog, DEBUG) << "Create display buffer from pending, w: "
 						  << width << ", h: " << height << ", bpp: " << bpp
 						  << ", offset: " << iter->second.offset
@@ -266,14 +403,27 @@ void BuffersStorage::handlePendingDisplayBuffers(uint64_t dbCookie,
 						  << hex << setfill('0') << setw(16)
 						  << dbCookie;
 
-		auto displayBuffer = mDisplay->createDisplayBuffer(width, height, bpp,
-														   iter->second.offset,
-														   mDomId,
-														   iter->second.refs,
-														   false);
+		DisplayBufferPtr displayBuffer;
+
+		try
+		{
+			displayBuffer = mDisplay->createDisplayBuffer(width, height, bpp,
+														  iter->second.offset,
+														  mDomId,
+														  iter->second.refs,
+														  false);
+		}
+		catch(const std::exception& e)
+		{
+			unreserve(usage);
+
+			throw;
+		}
 
 		mDisplayBuffers.emplace(dbCookie, displayBuffer);
 
+		mDisplayBuffersUsage[dbCookie].dumbBytes += usage.dumbBytes;
+
 		mPendingDisplayBuffers.erase(iter);
 	}
 }
@@ -301,3 +451,40 @@ FrameBufferPtr BuffersStorage::getFrameBufferUnlocked(uint64_t fbCookie)
 
 	return iter->second;
 }
+
+void BuffersStorage::reserve(const Quota& quota)
+{
+	lock_guard<mutex> lock(sUsageMutex);
+
+	auto& usage = sUsage[mDomId];
+
+	if ((sLimits.dumbBytes &&
+		 usage.dumbBytes + quota.dumbBytes > sLimits.dumbBytes) ||
+		(sLimits.grantPages &&
+		 usage.grantPages + quota.grantPages > sLimits.grantPages) ||
+		(sLimits.frameBuffers &&
+		 usage.frameBuffers + quota.frameBuffers > sLimits.frameBuffers))
+	{
+		LOG(mLog, WARNING) << "Domain quota exceeded, dom id: " << mDomId
+						   << ", dumb bytes: " << usage.dumbBytes
+						   << ", grant pages: " << usage.grantPages
+						   << ", frame buffers: " << usage.frameBuffers;
+
+		throw XenBackend::Exception("Domain quota exceeded", ENOMEM);
+	}
+
+	usage.dumbBytes += quota.dumbBytes;
+	usage.grantPages += quota.grantPages;
+	usage.frameBuffers += quota.frameBuffers;
+}
+
+void BuffersStorage::unreserve(const Quota& quota)
+{
+	lock_guard<mutex> lock(sUsageMutex);
+
+	auto& usage = sUsage[mDomId];
+
+	usage.dumbBytes -= quota.dumbBytes;
+	usage.grantPages -= quota.grantPages;
+	usage.frameBuffers -= quota.frameBuffers;
+}
@@ -35,12 +35,35 @@ using std::move;
 
 /***************************************************************************//**
  * Storage for display and frame buffers
+ * Dumb bytes, grant pages and frame buffers are accounted per domain. If a
+ * buffer doesn't fit the domain quota, its creation fails with ENOMEM.
  * @ingroup displ_be
  ******************************************************************************/
 class BuffersStorage
 {
 public:
 
+	/**
+	 * Per domain resources, used for the limits and the usage
+	 */
+	struct Quota
+	{
+		size_t dumbBytes;
+		size_t grantPages;
+		size_t frameBuffers;
+	};
+
+	/**
+	 * Sets per domain limits
+	 * @param limits limits, 0 field value - no limit
+	 */
+	static void setLimits(const Quota& limits);
+
+	/**
+	 * Logs resources usage of all domains
+	 */
+	static void dumpStats();
+
 	/**
 	 * @param domId   domain id
 	 * @param display display object
@@ -87,6 +110,12 @@ public:
 	 * Returns frame buffer object
 	 * @param fbCookie frame buffer cookie
 	 */
+	DisplayItf::FrameBufferPtr getFrameBuffer(uint64_t fbCookie);
+
+	/**
+	 * Returns frame buffer object and copies its content if required
+	 * @param fbCookie frame buffer cookie
+	 */
 	DisplayItf::FrameBufferPtr getFrameBufferAndCopy(uint64_t fbCookie);
 
 	/**
@@ -103,6 +132,10 @@ public:
 
 private:
 
+	static Quota sLimits;
+	static std::unordered_map<domid_t, Quota> sUsage;
+	static std::mutex sUsageMutex;
+
 	domid_t mDomId;
 	DisplayItf::DisplayPtr mDisplay;
 	XenBackend::Log mLog;
@@ -117,12 +150,20 @@ private:
 	std::unordered_map<uint64_t, DisplayItf::FrameBufferPtr> mFrameBuffers;
 	std::unordered_map<uint64_t, DisplayItf::DisplayBufferPtr> mDisplayBuffers;
 	std::unordered_map<uint64_t, PendingBuffer> mPendingDisplayBuffers;
+	std::unordered_map<uint64_t, Quota> mDisplayBuffersUsage;
 
+	void createDisplayBufferUnlocked(uint64_t dbCookie, bool beAllocRefs,
+									 grant_ref_t startDirectory,
+									 size_t offset, uint32_t size,
+									 uint32_t width, uint32_t height,
+									 uint32_t bpp);
 	uint32_t getBpp(uint32_t format);
 	void handlePendingDisplayBuffers(uint64_t dbCookie, uint32_t width,
 									 uint32_t height, uint32_t pixelFormat);
 	DisplayItf::DisplayBufferPtr getDisplayBufferUnlocked(uint64_t dbCookie);
 	DisplayItf::FrameBufferPtr getFrameBufferUnlocked(uint64_t fbCookie);
+	void reserve(const Quota& quota);
+	void unreserve(const Quota& quota);
 };
 
 typedef std::shared_ptr<BuffersStorage> BuffersStoragePtr;
@@ -23,6 +23,8 @@
 #include <algorithm>
 #include <vector>
 
+#include <sys/mman.h>
+
 #include <xen/be/XenStore.hpp>
 
 #ifdef WITH_IVI_EXTENSION
@@ -41,8 +43,12 @@ using std::begin;
 using std::dynamic_pointer_cast;
 using std::end;
 using std::find_if;
+using std::lock_guard;
+using std::mutex;
 using std::string;
+using std::thread;
 using std::to_string;
+using std::unique_lock;
 using std::vector;
 
 using XenBackend::FrontendHandlerPtr;
@@ -58,29 +64,262 @@ CtrlRingBuffer::CtrlRingBuffer(DisplayPtr display,
 							   ConnectorPtr connector,
 							   BuffersStoragePtr buffersStorage,
 							   EventRingBufferPtr eventBuffer,
+							   FlipEventDispatcherPtr dispatcher,
 							   domid_t domId,
 							   evtchn_port_t port, grant_ref_t ref) :
 	RingBufferInBase<xen_displif_back_ring, xen_displif_sring,
 					 xendispl_req, xendispl_resp>(domId, port, ref),
-	mCommandHandler(display, connector, buffersStorage, eventBuffer),
+	mDisplay(display),
+	mCommandHandler(display, connector, buffersStorage, eventBuffer,
+					dispatcher),
+	mTerminate(false),
+	mRingBuffer(domId, ref, PROT_READ),
+	mSring(static_cast<const xen_displif_sring*>(mRingBuffer.get())),
+	mConsumedCount(0),
+	mRequestCount(0),
+	mBatchCount(0),
+	mBatchSize(0),
+	mMaxBatchSize(0),
 	mLog("ConCtrlRing")
 {
+	mThread = thread(&CtrlRingBuffer::run, this);
+
 	LOG(mLog, DEBUG) << "Create ctrl ring buffer";
 }
 
+CtrlRingBuffer::~CtrlRingBuffer()
+{
+	stop();
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	logStats();
+
+	LOG(mLog, DEBUG) << "Delete ctrl ring buffer";
+}
+
 void CtrlRingBuffer::processRequest(const xendispl_req& req)
 {
 	DLOG(mLog, DEBUG) << "Request received, cmd:"
 					  << static_cast<int>(req.operation);
 
+	mConsumedCount++;
+	mBatchSize++;
+
+	bool isDeferredReq;
+
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		isDeferredReq = isDeferred(req);
+
+		if (isDeferredReq)
+		{
+			mRequests.push_back(req);
+
+			mCondVar.notify_one();
+		}
+	}
+
+	if (!isDeferredReq)
+	{
+		mResponses.push_back(handleRequest(req));
+	}
+
+	// the batch ends when the frontend has no more requests in the ring
+
+	if (isRingEmpty())
+	{
+		sendResponses(mResponses);
+
+		updateStats();
+	}
+}
+
+bool CtrlRingBuffer::isRingEmpty()
+{
+	// the ring consumer index starts from 0 and each processRequest consumes
+	// one request
+
+	RING_IDX pending = *static_cast<const volatile RING_IDX*>(
+			&mSring->req_prod) - mConsumedCount;
+
+	// more pending requests than the ring fits means the indexes are out of
+	// sync: don't hold the responses then
+
+	return pending == 0 || pending > cRingSize;
+}
+
+void CtrlRingBuffer::updateStats()
+{
+	mRequestCount += mBatchSize;
+	mBatchCount++;
+
+	if (mBatchSize > mMaxBatchSize)
+	{
+		mMaxBatchSize = mBatchSize;
+	}
+
+	DLOG(mLog, DEBUG) << "Batch size: " << mBatchSize;
+
+	mBatchSize = 0;
+
+	if (mBatchCount % cStatsPeriod == 0)
+	{
+		logStats();
+	}
+}
+
+void CtrlRingBuffer::logStats()
+{
+	if (!mBatchCount)
+	{
+		return;
+	}
+
+	LOG(mLog, DEBUG) << "Requests: " << mRequestCount
+					 << ", batches: " << mBatchCount
+					 << ", avg batch: "
+					 << static_cast<double>(mRequestCount) / mBatchCount
+					 << ", max batch: " << mMaxBatchSize;
+}
+
+bool CtrlRingBuffer::isDeferred(const xendispl_req& req)
+{
+	if (req.operation == XENDISPL_OP_DBUF_CREATE ||
+		req.operation == XENDISPL_OP_SET_CONFIG)
+	{
+		return true;
+	}
+
+	// the queue holds the request being handled as well: while it is not
+	// empty, the command handler is busy on the worker thread
+
+	return !mRequests.empty();
+}
+
+xendispl_resp CtrlRingBuffer::handleRequest(const xendispl_req& req)
+{
 	xendispl_resp rsp {};
 
-	rsp.id = req.id;
 	rsp.id = req.id;
 	rsp.operation = req.operation;
 	rsp.status = mCommandHandler.processCommand(req, rsp);
 
-	sendResponse(rsp);
+	return rsp;
+}
+
+int CtrlRingBuffer::flushDisplay()
+{
+	try
+	{
+		mDisplay->flush();
+	}
+	catch(const XenBackend::Exception& e)
+	{
+		LOG(mLog, ERROR) << e.what();
+
+		return e.getErrno() > 0 ? -e.getErrno() : -EIO;
+	}
+	catch(const std::exception& e)
+	{
+		LOG(mLog, ERROR) << e.what();
+
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void CtrlRingBuffer::sendResponses(vector<xendispl_resp>& responses)
+{
+	if (responses.empty())
+	{
+		return;
+	}
+
+	// one flush per batch, its error is reported to the requests of the
+	// batch which succeeded
+
+	int status = flushDisplay();
+
+	if (status)
+	{
+		for (auto& rsp : responses)
+		{
+			if (!rsp.status)
+			{
+				rsp.status = status;
+			}
+		}
+	}
+
+	// responses are sent from the ring and the worker threads
+
+	lock_guard<mutex> lock(mResponseMutex);
+
+	// the frontend is notified only if it waits for the response, so the
+	// responses pushed back to back take one notification
+
+	for (auto& rsp : responses)
+	{
+		sendResponse(rsp);
+	}
+
+	responses.clear();
+}
+
+void CtrlRingBuffer::run()
+{
+	unique_lock<mutex> lock(mMutex);
+
+	while(true)
+	{
+		mCondVar.wait(lock, [this] { return !mRequests.empty() ||
+									 mTerminate; });
+
+		if (mTerminate)
+		{
+			break;
+		}
+
+		// the request stays in the queue while it is handled: requests
+		// received meanwhile are queued behind it
+
+		auto req = mRequests.front();
+
+		lock.unlock();
+
+		DLOG(mLog, DEBUG) << "Handle deferred request, cmd:"
+						  << static_cast<int>(req.operation);
+
+		mWorkerResponses.push_back(handleRequest(req));
+
+		lock.lock();
+
+		mRequests.pop_front();
+
+		if (mRequests.empty())
+		{
+			lock.unlock();
+
+			sendResponses(mWorkerResponses);
+
+			lock.lock();
+		}
+	}
+}
+
+void CtrlRingBuffer::stop()
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mTerminate = true;
+
+	mCondVar.notify_one();
 }
 
 /*******************************************************************************
@@ -93,6 +332,8 @@ void DisplayFrontendHandler::onBind()
 
 	BuffersStoragePtr buffersStorage(new BuffersStorage(getDomId(), mDisplay));
 
+	FlipEventDispatcherPtr dispatcher(new FlipEventDispatcher());
+
 	string conBasePath = getXsFrontendPath() + "/";
 	int conIndex = 0;
 
@@ -101,7 +342,7 @@ void DisplayFrontendHandler::onBind()
 		LOG(mLog, DEBUG) << "Found connector: " << conIndex;
 
 		createConnector(conBasePath + to_string(conIndex) + "/",
-						conIndex, buffersStorage);
+						conIndex, buffersStorage, dispatcher);
 
 		conIndex++;
 	}
@@ -109,7 +350,8 @@ void DisplayFrontendHandler::onBind()
 
 void DisplayFrontendHandler::createConnector(const string& conPath,
 											 int conIndex,
-											 BuffersStoragePtr bufferStorage)
+											 BuffersStoragePtr bufferStorage,
+											 FlipEventDispatcherPtr dispatcher)
 {
 	evtchn_port_t port = getXenStore().readInt(conPath +
 											   XENDISPL_FIELD_EVT_CHANNEL);
@@ -141,6 +383,7 @@ void DisplayFrontendHandler::createConnector(const string& conPath,
 							   connector,
 							   bufferStorage,
 							   eventRingBuffer,
+							   dispatcher,
 							   getDomId(), port, ref));
 
 	addRingBuffer(ctrlRingBuffer);
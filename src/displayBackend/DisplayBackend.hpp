@@ -21,10 +21,17 @@
 #ifndef DISPLAYBACKEND_HPP_
 #define DISPLAYBACKEND_HPP_
 
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <xen/be/BackendBase.hpp>
 #include <xen/be/FrontendHandlerBase.hpp>
 #include <xen/be/RingBufferBase.hpp>
 #include <xen/be/Log.hpp>
+#include <xen/be/XenGnttab.hpp>
 
 #include "DisplayCommandHandler.hpp"
 
@@ -35,6 +42,17 @@
 
 /***************************************************************************//**
  * Ring buffer used for the connector control.
+ * Slow requests (DBUF_CREATE, SET_CONFIG) are handled by a worker thread and
+ * their responses are sent out of order when done. Requests received while
+ * the worker is busy are queued behind and handled by the worker as well, so
+ * the requests keep their order and the command handler is never called from
+ * both threads at once.
+ * The requests consumed till the ring is empty form a batch: responses of
+ * the requests handled on the ring thread are sent together at the end of
+ * the batch, the worker sends its responses when its queue is empty. The
+ * display is flushed once before the responses are sent, a flush error fails
+ * the requests of the batch. Batch
+ * size statistics are logged every cStatsPeriod batches and on delete.
  * @ingroup displ_be
  ******************************************************************************/
 class CtrlRingBuffer : public XenBackend::RingBufferInBase<
@@ -46,6 +64,7 @@ public:
 	 * @param connector      connector object
 	 * @param buffersStorage buffers storage
 	 * @param eventBuffer    event ring buffer
+	 * @param dispatcher     flip event dispatcher
 	 * @param domId          frontend domain id
 	 * @param port           event channel port number
 	 * @param ref            grant table reference
@@ -54,14 +73,48 @@ public:
 				   DisplayItf::ConnectorPtr connector,
 				   BuffersStoragePtr buffersStorage,
 				   EventRingBufferPtr eventBuffer,
+				   FlipEventDispatcherPtr dispatcher,
 				   domid_t domId, evtchn_port_t port, grant_ref_t ref);
+	~CtrlRingBuffer();
 
 private:
 
+	const uint64_t cStatsPeriod = 1000;
+	const RING_IDX cRingSize = __CONST_RING_SIZE(xen_displif, XC_PAGE_SIZE);
+
+	DisplayItf::DisplayPtr mDisplay;
 	DisplayCommandHandler mCommandHandler;
+	bool mTerminate;
+	// read only mapping of the shared ring to check the producer index
+	XenBackend::XenGnttabBuffer mRingBuffer;
+	const xen_displif_sring* mSring;
+	RING_IDX mConsumedCount;
+	uint64_t mRequestCount;
+	uint64_t mBatchCount;
+	uint64_t mBatchSize;
+	uint64_t mMaxBatchSize;
 	XenBackend::Log mLog;
 
+	std::list<xendispl_req> mRequests;
+	// responses held till the end of the batch on the ring and worker threads
+	std::vector<xendispl_resp> mResponses;
+	std::vector<xendispl_resp> mWorkerResponses;
+
+	std::mutex mMutex;
+	std::mutex mResponseMutex;
+	std::condition_variable mCondVar;
+	std::thread mThread;
+
 	void processRequest(const xendispl_req& req);
+	bool isRingEmpty();
+	void updateStats();
+	void logStats();
+	bool isDeferred(const xendispl_req& req);
+	xendispl_resp handleRequest(const xendispl_req& req);
+	int flushDisplay();
+	void sendResponses(std::vector<xendispl_resp>& responses);
+	void run();
+	void stop();
 };
 
 typedef std::shared_ptr<CtrlRingBuffer> CtrlRingBufferPtr;
@@ -100,7 +153,8 @@ private:
 	XenBackend::Log mLog;
 
 	void createConnector(const std::string& streamPath, int conIndex,
-						 BuffersStoragePtr bufferStorage);
+						 BuffersStoragePtr bufferStorage,
+						 FlipEventDispatcherPtr dispatcher);
 };
 
 /***************************************************************************//**
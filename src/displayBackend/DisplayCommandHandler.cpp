@@ -23,16 +23,24 @@
 #include <cassert>
 #include <iomanip>
 
+#include <sys/mman.h>
+
 #include <xen/be/Exception.hpp>
 
+using std::chrono::milliseconds;
 using std::dec;
 using std::hex;
+using std::lock_guard;
+using std::mutex;
 using std::setfill;
 using std::setw;
+using std::thread;
+using std::unique_lock;
 using std::unordered_map;
 
 using DisplayItf::ConnectorPtr;
 using DisplayItf::DisplayPtr;
+using DisplayItf::FrameBufferPtr;
 
 /*******************************************************************************
  * Protocol differences between its versions and their implications
@@ -69,11 +77,194 @@ EventRingBuffer::EventRingBuffer(int conIndex, domid_t domId,
 	RingBufferOutBase<xendispl_event_page, xendispl_evt>(domId, port, ref,
 														 offset, size),
 	mConIndex(conIndex),
+	mNumEvents(size / sizeof(xendispl_evt)),
+	mPageBuffer(domId, ref, PROT_READ),
+	mPage(static_cast<const xendispl_event_page*>(mPageBuffer.get())),
 	mLog("ConEventRing")
 {
 	LOG(mLog, DEBUG) << "Create event ring buffer, index: " << mConIndex;
 }
 
+bool EventRingBuffer::isFull() const
+{
+	return mPage->in_prod - mPage->in_cons >= mNumEvents;
+}
+
+/*******************************************************************************
+ * FlipEventDispatcher
+ ******************************************************************************/
+
+FlipEventDispatcher::FlipEventDispatcher() :
+	mTerminate(false),
+	mHasPending(false),
+	mRingFull(false),
+	mQueuedCount(0),
+	mDeliveredCount(0),
+	mCoalescedCount(0),
+	mRingFullCount(0),
+	mFailedCount(0),
+	mLog("FlipEventDispatcher")
+{
+	mThread = thread(&FlipEventDispatcher::run, this);
+
+	LOG(mLog, DEBUG) << "Create";
+}
+
+FlipEventDispatcher::~FlipEventDispatcher()
+{
+	stop();
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	LOG(mLog, DEBUG) << "Delete, events queued: " << mQueuedCount
+					 << ", delivered: " << mDeliveredCount
+					 << ", coalesced: " << mCoalescedCount
+					 << ", ring full: " << mRingFullCount
+					 << ", failed: " << mFailedCount;
+}
+
+void FlipEventDispatcher::sendFlipEvent(EventRingBufferPtr eventBuffer,
+										uint64_t fbCookie)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto it = mEvents.find(eventBuffer);
+
+	if (it == mEvents.end())
+	{
+		return;
+	}
+
+	mQueuedCount++;
+
+	auto& state = it->second;
+
+	if (state.pending)
+	{
+		mCoalescedCount++;
+
+		DLOG(mLog, WARNING) << "Coalesce flip event, fb ID: "
+							<< hex << setfill('0') << setw(16)
+							<< state.fbCookie;
+	}
+
+	state.fbCookie = fbCookie;
+	state.pending = true;
+
+	if (!mHasPending)
+	{
+		mHasPending = true;
+
+		mCondVar.notify_one();
+	}
+}
+
+void FlipEventDispatcher::addEventBuffer(EventRingBufferPtr eventBuffer)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mEvents.emplace(eventBuffer, EventState {});
+}
+
+void FlipEventDispatcher::removeEventBuffer(EventRingBufferPtr eventBuffer)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mEvents.erase(eventBuffer);
+}
+
+void FlipEventDispatcher::run()
+{
+	unique_lock<mutex> lock(mMutex);
+
+	while(!mTerminate)
+	{
+		if (mRingFull)
+		{
+			mCondVar.wait_for(lock, milliseconds(cRetryTimeoutMs),
+							  [this] { return mTerminate; });
+		}
+		else
+		{
+			mCondVar.wait(lock, [this] { return mHasPending || mTerminate; });
+		}
+
+		if (mTerminate)
+		{
+			break;
+		}
+
+		deliverEvents();
+	}
+}
+
+void FlipEventDispatcher::stop()
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mTerminate = true;
+
+	mCondVar.notify_one();
+}
+
+void FlipEventDispatcher::deliverEvents()
+{
+	mHasPending = false;
+	mRingFull = false;
+
+	for (auto& item : mEvents)
+	{
+		auto& state = item.second;
+
+		if (!state.pending)
+		{
+			continue;
+		}
+
+		DLOG(mLog, DEBUG) << "Event [PAGE FLIP], fb ID: "
+						  << hex << setfill('0') << setw(16)
+						  << state.fbCookie;
+
+		xendispl_evt event {};
+
+		event.type = XENDISPL_EVT_PG_FLIP;
+		event.op.pg_flip.fb_cookie = state.fbCookie;
+		event.id = state.eventId;
+
+		if (item.first->isFull())
+		{
+			// keep the event and retry later
+
+			mHasPending = true;
+			mRingFull = true;
+
+			mRingFullCount++;
+
+			continue;
+		}
+
+		try
+		{
+			item.first->sendEvent(event);
+
+			state.eventId++;
+
+			mDeliveredCount++;
+		}
+		catch(const std::exception& e)
+		{
+			LOG(mLog, ERROR) << "Can't send event: " << e.what();
+
+			mFailedCount++;
+		}
+
+		state.pending = false;
+	}
+}
+
 /*******************************************************************************
  * CommandHandler
  ******************************************************************************/
@@ -82,19 +273,30 @@ DisplayCommandHandler::DisplayCommandHandler(
 		DisplayPtr display,
 		ConnectorPtr connector,
 		BuffersStoragePtr buffersStorage,
-		EventRingBufferPtr eventBuffer) :
+		EventRingBufferPtr eventBuffer,
+		FlipEventDispatcherPtr dispatcher) :
 	mDisplay(display),
 	mConnector(connector),
 	mBuffersStorage(buffersStorage),
 	mEventBuffer(eventBuffer),
-	mEventId(0),
+	mDispatcher(dispatcher),
+	mVisible(true),
+	mSkippedCopies(0),
+	mHasSkippedFb(false),
+	mSkippedFbCookie(0),
+	mSkippedCopyError(0),
 	mLog("CommandHandler")
 {
 	assert(display);
 	assert(connector);
 	assert(buffersStorage);
 	assert(eventBuffer);
-	
+	assert(dispatcher);
+
+	mDispatcher->addEventBuffer(mEventBuffer);
+
+	mConnector->setVisibleCallback([this]() { onVisible(); });
+
 	LOG(mLog, DEBUG) << "Create command handler, connector name: "
 					 << mConnector->getName();
 }
@@ -102,7 +304,12 @@ DisplayCommandHandler::DisplayCommandHandler(
 DisplayCommandHandler::~DisplayCommandHandler()
 {
 	LOG(mLog, DEBUG) << "Delete command handler, connector name: "
-					 << mConnector->getName();
+					 << mConnector->getName()
+					 << ", skipped copies: " << mSkippedCopies;
+
+	mDispatcher->removeEventBuffer(mEventBuffer);
+
+	mConnector->setVisibleCallback(nullptr);
 
 	mConnector.reset();
 }
@@ -119,8 +326,6 @@ int DisplayCommandHandler::processCommand(const xendispl_req& req,
 	try
 	{
 		(this->*sCmdTable.at(req.operation))(req, rsp);
-
-		mDisplay->flush();
 	}
 	catch(const XenBackend::Exception& e)
 	{
@@ -170,10 +375,113 @@ void DisplayCommandHandler::pageFlip(const xendispl_req& req,
 					  << hex << setfill('0') << setw(16)
 					  << cookie;
 
-	mConnector->pageFlip(mBuffersStorage->getFrameBufferAndCopy(cookie),
+	// While the connector is not visible, the flip is completed without
+	// copying the buffer content. The last skipped FB is copied once when the
+	// connector becomes visible, or by the next flip if it comes first.
+	// If that copy fails, e.g. the FB can't be mapped, the error is returned
+	// by the next flip.
+
+	{
+		lock_guard<mutex> lock(mSkippedMutex);
+
+		if (mSkippedCopyError)
+		{
+			auto error = mSkippedCopyError;
+
+			mSkippedCopyError = 0;
+
+			throw XenBackend::Exception("Can't copy skipped FB", error);
+		}
+	}
+
+	bool visible = mConnector->isVisible();
+
+	if (visible != mVisible)
+	{
+		mVisible = visible;
+
+		LOG(mLog, DEBUG) << "Connector " << mConnector->getName()
+						 << (mVisible ? " is visible" : " is not visible")
+						 << ", skipped copies: " << mSkippedCopies;
+	}
+
+	FrameBufferPtr frameBuffer;
+
+	if (mVisible)
+	{
+		frameBuffer = mBuffersStorage->getFrameBufferAndCopy(cookie);
+	}
+	else
+	{
+		frameBuffer = mBuffersStorage->getFrameBuffer(cookie);
+
+		mSkippedCopies++;
+	}
+
+	{
+		lock_guard<mutex> lock(mSkippedMutex);
+
+		mHasSkippedFb = !mVisible;
+		mSkippedFbCookie = cookie;
+	}
+
+	mConnector->pageFlip(frameBuffer,
 						 [cookie, this] () { sendFlipEvent(cookie); });
 }
 
+void DisplayCommandHandler::onVisible()
+{
+	// called by the connector before it redraws the current buffer
+
+	uint64_t cookie;
+
+	{
+		lock_guard<mutex> lock(mSkippedMutex);
+
+		if (!mHasSkippedFb)
+		{
+			return;
+		}
+
+		mHasSkippedFb = false;
+		cookie = mSkippedFbCookie;
+	}
+
+	LOG(mLog, DEBUG) << "Connector " << mConnector->getName()
+					 << " is visible, copy skipped FB: "
+					 << hex << setfill('0') << setw(16) << cookie;
+
+	try
+	{
+		mBuffersStorage->getFrameBufferAndCopy(cookie);
+	}
+	catch(const XenBackend::Exception& e)
+	{
+		// the FB may be already detached
+
+		if (e.getErrno() == ENOENT)
+		{
+			LOG(mLog, WARNING) << e.what();
+
+			return;
+		}
+
+		LOG(mLog, ERROR) << e.what();
+
+		lock_guard<mutex> lock(mSkippedMutex);
+
+		mSkippedCopyError = e.getErrno() > 0 ? e.getErrno() : EIO;
+	}
+	catch(const std::exception& e)
+	{
+		LOG(mLog, ERROR) << e.what();
+
+		lock_guard<mutex> lock(mSkippedMutex);
+
+		mSkippedCopyError = EIO;
+	}
+}
+
 void DisplayCommandHandler::createDisplayBuffer(const xendispl_req& req,
 												xendispl_resp& rsp)
 {
@@ -292,15 +600,9 @@ void DisplayCommandHandler::getEDID(const xendispl_req& req,
 
 void DisplayCommandHandler::sendFlipEvent(uint64_t fbCookie)
 {
-	DLOG(mLog, DEBUG) << "Event [PAGE FLIP], conn name: "
+	DLOG(mLog, DEBUG) << "Flip done, conn name: "
 					  << mConnector->getName() << ", fb ID: "
 					  << hex << setfill('0') << setw(16) << fbCookie;
 
-	xendispl_evt event {};
-
-	event.type = XENDISPL_EVT_PG_FLIP;
-	event.op.pg_flip.fb_cookie = fbCookie;
-	event.id = mEventId++;
-
-	mEventBuffer->sendEvent(event);
+	mDispatcher->sendFlipEvent(mEventBuffer, fbCookie);
 }
@@ -21,12 +21,16 @@
 #ifndef SRC_DISPLAYCOMMANDHANDLER_HPP_
 #define SRC_DISPLAYCOMMANDHANDLER_HPP_
 
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <xen/be/RingBufferBase.hpp>
 #include <xen/be/Log.hpp>
+#include <xen/be/XenGnttab.hpp>
 
 #include "BuffersStorage.hpp"
 #include "DisplayItf.hpp"
@@ -50,13 +54,92 @@ public:
 	EventRingBuffer(int conIndex, domid_t domId, evtchn_port_t port,
 					grant_ref_t ref, int offset, size_t size);
 
+	/**
+	 * Returns true if there is no room for an event in the ring
+	 */
+	bool isFull() const;
+
 private:
 	int mConIndex;
+	size_t mNumEvents;
+	// read only mapping of the event page to check the ring indexes
+	XenBackend::XenGnttabBuffer mPageBuffer;
+	const xendispl_event_page* mPage;
 	XenBackend::Log mLog;
 };
 
 typedef std::shared_ptr<EventRingBuffer> EventRingBufferPtr;
 
+/***************************************************************************//**
+ * Delivers page flip events of all connectors of one frontend.
+ * Flip completion only queues the event, the events which are queued by the
+ * time the delivery thread wakes up (usually completed within the same
+ * vblank) are sent in one pass.
+ * If the event ring is full, the event stays queued and the delivery is
+ * retried. An event which fails to be sent otherwise is dropped. A next flip
+ * event of the same connector supersedes the queued one: only the latest
+ * frame buffer is reported. Events of not added event buffers are ignored.
+ * @ingroup displ_be
+ ******************************************************************************/
+class FlipEventDispatcher
+{
+public:
+
+	FlipEventDispatcher();
+	~FlipEventDispatcher();
+
+	/**
+	 * Queues page flip event. Returns immediately.
+	 * @param eventBuffer connector event ring buffer
+	 * @param fbCookie    frame buffer cookie
+	 */
+	void sendFlipEvent(EventRingBufferPtr eventBuffer, uint64_t fbCookie);
+
+	/**
+	 * Starts delivering events of the connector
+	 * @param eventBuffer connector event ring buffer
+	 */
+	void addEventBuffer(EventRingBufferPtr eventBuffer);
+
+	/**
+	 * Drops queued events of the connector
+	 * @param eventBuffer connector event ring buffer
+	 */
+	void removeEventBuffer(EventRingBufferPtr eventBuffer);
+
+private:
+
+	const uint32_t cRetryTimeoutMs = 10;
+
+	struct EventState
+	{
+		uint64_t fbCookie;
+		uint16_t eventId;
+		bool pending;
+	};
+
+	std::unordered_map<EventRingBufferPtr, EventState> mEvents;
+	bool mTerminate;
+	bool mHasPending;
+	bool mRingFull;
+	uint64_t mQueuedCount;
+	uint64_t mDeliveredCount;
+	uint64_t mCoalescedCount;
+	uint64_t mRingFullCount;
+	uint64_t mFailedCount;
+	XenBackend::Log mLog;
+
+	std::mutex mMutex;
+	std::condition_variable mCondVar;
+	std::thread mThread;
+
+	void run();
+	void stop();
+	void deliverEvents();
+};
+
+typedef std::shared_ptr<FlipEventDispatcher> FlipEventDispatcherPtr;
+
 /**
  * Handles commands received from the frontend.
  * @ingroup displ_be
@@ -69,11 +152,13 @@ public:
 	 * @param connector      connector object
 	 * @param buffersStorage buffers storage
 	 * @param eventBuffer    event ring buffer
+	 * @param dispatcher     flip event dispatcher
 	 */
 	DisplayCommandHandler(DisplayItf::DisplayPtr display,
 						  DisplayItf::ConnectorPtr connector,
 						  BuffersStoragePtr buffersStorage,
-						  EventRingBufferPtr eventBuffer);
+						  EventRingBufferPtr eventBuffer,
+						  FlipEventDispatcherPtr dispatcher);
 	~DisplayCommandHandler();
 
 	/**
@@ -94,10 +179,19 @@ private:
 	DisplayItf::ConnectorPtr mConnector;
 	BuffersStoragePtr mBuffersStorage;
 	EventRingBufferPtr mEventBuffer;
-	uint16_t mEventId;
+	FlipEventDispatcherPtr mDispatcher;
+	bool mVisible;
+	uint64_t mSkippedCopies;
+	// FB flipped without copy, copied when the connector becomes visible
+	bool mHasSkippedFb;
+	uint64_t mSkippedFbCookie;
+	// error of the skipped FB copy, returned by the next flip
+	int mSkippedCopyError;
 
 	XenBackend::Log mLog;
 
+	std::mutex mSkippedMutex;
+
 	void pageFlip(const xendispl_req& req, xendispl_resp& rsp);
 	void createDisplayBuffer(const xendispl_req& req, xendispl_resp& rsp);
 	void destroyDisplayBuffer(const xendispl_req& req, xendispl_resp& rsp);
@@ -107,6 +201,7 @@ private:
 	void getEDID(const xendispl_req& req, xendispl_resp& rsp);
 
 	void sendFlipEvent(uint64_t fbCookie);
+	void onVisible();
 };
 
 #endif /* SRC_DISPLAYCOMMANDHANDLER_HPP_ */
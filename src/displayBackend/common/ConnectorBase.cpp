@@ -25,6 +25,9 @@
 #include "ConnectorBase.hpp"
 #include "drm_edid.h"
 
+using std::lock_guard;
+using std::mutex;
+
 using XenBackend::Exception;
 using XenBackend::XenGnttabBuffer;
 
@@ -36,10 +39,33 @@ ConnectorBase::ConnectorBase(domid_t domId, uint32_t width, uint32_t height) :
 {
 }
 
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void ConnectorBase::setVisibleCallback(VisibleCallback cbk)
+{
+	// when it returns, the previous callback is not called anymore
+
+	lock_guard<mutex> lock(mVisibleMutex);
+
+	mVisibleCallback = cbk;
+}
+
 /*******************************************************************************
  * Protected
  ******************************************************************************/
 
+void ConnectorBase::onVisible()
+{
+	lock_guard<mutex> lock(mVisibleMutex);
+
+	if (mVisibleCallback)
+	{
+		mVisibleCallback();
+	}
+}
+
 void ConnectorBase::edidPutBlockCheckSum(uint8_t* edidBlock)
 {
 	int i{0}, checkSum{0};
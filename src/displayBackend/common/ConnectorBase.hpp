@@ -22,6 +22,8 @@
 #ifndef SRC_CONNECTOR_BASE_HPP_
 #define SRC_CONNECTOR_BASE_HPP_
 
+#include <mutex>
+
 #include <xen/be/Log.hpp>
 
 #include "DisplayItf.hpp"
@@ -35,6 +37,14 @@ struct edid;
  ******************************************************************************/
 class ConnectorBase : public DisplayItf::Connector
 {
+public:
+
+	/**
+	 * Sets callback which is called when the connector becomes visible
+	 * @param cbk callback, nullptr to reset
+	 */
+	void setVisibleCallback(VisibleCallback cbk) override;
+
 protected:
 
 	domid_t mDomId;
@@ -59,8 +69,17 @@ protected:
 	 */
 	size_t getEDID(grant_ref_t startDirectory, uint32_t size);
 
+	/**
+	 * Calls the visible callback. Shall not be called under locks taken by
+	 * the callback user, i.e. while drawing.
+	 */
+	void onVisible();
+
 private:
 
+	std::mutex mVisibleMutex;
+	VisibleCallback mVisibleCallback;
+
 	/* Refresh rate advertized via EDID detailed timings. */
 	const int EDID_REFRESH_RATE_HZ = 60;
 
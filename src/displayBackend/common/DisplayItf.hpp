@@ -141,6 +141,11 @@ public:
 	 */
 	typedef std::function<void()> FlipCallback;
 
+	/**
+	 * Callback which is called when the connector becomes visible
+	 */
+	typedef std::function<void()> VisibleCallback;
+
 	virtual ~Connector() {};
 
 	/**
@@ -160,6 +165,21 @@ public:
 	 */
 	virtual bool isInitialized() const = 0;
 
+	/**
+	 * Checks if the connector content is displayed
+	 * @return <i>false</i> if the content is not visible and updating it
+	 * may be skipped
+	 */
+	virtual bool isVisible() const = 0;
+
+	/**
+	 * Sets callback which is called when the connector becomes visible.
+	 * The connector content is redrawn after the callback returns, so the
+	 * callback may update the content skipped while not visible.
+	 * @param cbk callback, nullptr to reset
+	 */
+	virtual void setVisibleCallback(VisibleCallback cbk) = 0;
+
 	/**
 	 * Initializes connector
 	 * @param width       width
@@ -0,0 +1,277 @@
+/*
+ *  Lazy grant table buffer
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "LazyGnttabBuffer.hpp"
+
+#include <sys/mman.h>
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::lock_guard;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+using XenBackend::XenGnttabBuffer;
+
+/*******************************************************************************
+ * LazyGnttabBuffer
+ ******************************************************************************/
+
+LazyGnttabBuffer::LazyGnttabBuffer(domid_t domId, const GrantRefs& refs,
+								   size_t offset) :
+	mDomId(domId),
+	mRefs(refs),
+	mOffset(offset),
+	mMappedSize(refs.size() * XC_PAGE_SIZE),
+	mCacheIt(GnttabMapCache::getInstance().mBuffers.end())
+{
+}
+
+LazyGnttabBuffer::~LazyGnttabBuffer()
+{
+	GnttabMapCache::getInstance().remove(this);
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void LazyGnttabBuffer::lock()
+{
+	mMutex.lock();
+
+	if (mGnttabBuffer)
+	{
+		GnttabMapCache::getInstance().onUsed(this);
+
+		return;
+	}
+
+	try
+	{
+		mGnttabBuffer.reset(
+				new XenGnttabBuffer(mDomId, mRefs.data(), mRefs.size(),
+									PROT_READ | PROT_WRITE, mOffset));
+	}
+	catch(const std::exception& e)
+	{
+		mMutex.unlock();
+
+		throw;
+	}
+
+	GnttabMapCache::getInstance().onMapped(this);
+}
+
+void LazyGnttabBuffer::unlock()
+{
+	mMutex.unlock();
+}
+
+/*******************************************************************************
+ * GnttabMapCache
+ ******************************************************************************/
+
+GnttabMapCache::GnttabMapCache() :
+	mDomainLimit(0),
+	mTerminate(false),
+	mIdleUnmapCount(0),
+	mLimitUnmapCount(0),
+	mLog("GnttabMapCache")
+{
+	mThread = thread(&GnttabMapCache::run, this);
+}
+
+GnttabMapCache::~GnttabMapCache()
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		mTerminate = true;
+
+		mCondVar.notify_one();
+	}
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+}
+
+GnttabMapCache& GnttabMapCache::getInstance()
+{
+	static GnttabMapCache sGnttabMapCache;
+
+	return sGnttabMapCache;
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void GnttabMapCache::setDomainLimit(size_t limit)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	LOG(mLog, DEBUG) << "Set domain limit: " << limit;
+
+	mDomainLimit = limit;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void GnttabMapCache::onMapped(LazyGnttabBuffer* buffer)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	buffer->mLastUsed = steady_clock::now();
+
+	buffer->mCacheIt = mBuffers.insert(mBuffers.begin(), buffer);
+
+	auto& mappedBytes = mMappedBytes[buffer->mDomId];
+
+	mappedBytes += buffer->mMappedSize;
+
+	DLOG(mLog, DEBUG) << "Map, dom id: " << buffer->mDomId
+					  << ", size: " << buffer->mMappedSize
+					  << ", mapped: " << mappedBytes;
+
+	if (!mDomainLimit)
+	{
+		return;
+	}
+
+	// unmap least recently used buffers of the domain to fit the limit
+
+	auto it = mBuffers.end();
+
+	while(mappedBytes > mDomainLimit && it != mBuffers.begin())
+	{
+		auto candidate = *--it;
+
+		if (candidate == buffer || candidate->mDomId != buffer->mDomId)
+		{
+			continue;
+		}
+
+		if (unmap(candidate))
+		{
+			it = mBuffers.erase(it);
+
+			mLimitUnmapCount++;
+		}
+	}
+
+	if (mappedBytes > mDomainLimit)
+	{
+		LOG(mLog, WARNING) << "Mapped size exceeds the limit, dom id: "
+						   << buffer->mDomId << ", mapped: " << mappedBytes;
+	}
+}
+
+void GnttabMapCache::onUsed(LazyGnttabBuffer* buffer)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	buffer->mLastUsed = steady_clock::now();
+
+	if (buffer->mCacheIt != mBuffers.end())
+	{
+		mBuffers.splice(mBuffers.begin(), mBuffers, buffer->mCacheIt);
+	}
+}
+
+void GnttabMapCache::remove(LazyGnttabBuffer* buffer)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	if (buffer->mCacheIt != mBuffers.end())
+	{
+		mMappedBytes[buffer->mDomId] -= buffer->mMappedSize;
+
+		mBuffers.erase(buffer->mCacheIt);
+
+		buffer->mCacheIt = mBuffers.end();
+	}
+}
+
+bool GnttabMapCache::unmap(LazyGnttabBuffer* buffer)
+{
+	// skip the buffer if it is being accessed
+
+	if (!buffer->mMutex.try_lock())
+	{
+		return false;
+	}
+
+	buffer->mGnttabBuffer.reset();
+	buffer->mCacheIt = mBuffers.end();
+
+	buffer->mMutex.unlock();
+
+	mMappedBytes[buffer->mDomId] -= buffer->mMappedSize;
+
+	DLOG(mLog, DEBUG) << "Unmap, dom id: " << buffer->mDomId
+					  << ", size: " << buffer->mMappedSize
+					  << ", mapped: " << mMappedBytes[buffer->mDomId]
+					  << ", unmapped idle: " << mIdleUnmapCount
+					  << ", over limit: " << mLimitUnmapCount;
+
+	return true;
+}
+
+void GnttabMapCache::unmapIdle()
+{
+	auto now = steady_clock::now();
+
+	for (auto it = mBuffers.begin(); it != mBuffers.end();)
+	{
+		if (now - (*it)->mLastUsed > milliseconds(cIdleTimeoutMs) &&
+			unmap(*it))
+		{
+			it = mBuffers.erase(it);
+
+			mIdleUnmapCount++;
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
+
+void GnttabMapCache::run()
+{
+	unique_lock<mutex> lock(mMutex);
+
+	while(!mTerminate)
+	{
+		mCondVar.wait_for(lock, milliseconds(cCheckPeriodMs),
+						  [this] { return mTerminate; });
+
+		if (!mTerminate)
+		{
+			unmapIdle();
+		}
+	}
+}
@@ -0,0 +1,148 @@
+/*
+ *  Lazy grant table buffer
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_LAZY_GNTTAB_BUFFER_HPP_
+#define SRC_LAZY_GNTTAB_BUFFER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <xen/be/Log.hpp>
+#include <xen/be/XenGnttab.hpp>
+
+#include "PgDirSharedBuffer.hpp"
+
+/***************************************************************************//**
+ * Grant table buffer which is mapped on first access.
+ * The buffer is accessed between lock() and unlock(), so it can be used with
+ * std::lock_guard. While unlocked, the buffer may be unmapped by
+ * GnttabMapCache and it is mapped again on next lock().
+ * @ingroup displ_be
+ ******************************************************************************/
+class LazyGnttabBuffer
+{
+public:
+
+	/**
+	 * @param domId  domain id
+	 * @param refs   grant table refs
+	 * @param offset offset of the data in the buffer
+	 */
+	LazyGnttabBuffer(domid_t domId, const GrantRefs& refs, size_t offset);
+	~LazyGnttabBuffer();
+
+	/**
+	 * Maps the buffer if required and prevents it from unmapping
+	 */
+	void lock();
+
+	/**
+	 * Allows the buffer unmapping
+	 */
+	void unlock();
+
+	/**
+	 * Returns pointer to the buffer data, valid while locked
+	 */
+	void* get() const { return mGnttabBuffer->get(); }
+
+	/**
+	 * Returns the buffer size, valid while locked
+	 */
+	size_t size() const { return mGnttabBuffer->size(); }
+
+private:
+
+	friend class GnttabMapCache;
+
+	domid_t mDomId;
+	GrantRefs mRefs;
+	size_t mOffset;
+	size_t mMappedSize;
+	std::chrono::steady_clock::time_point mLastUsed;
+	// position in the cache list, valid while mapped
+	std::list<LazyGnttabBuffer*>::iterator mCacheIt;
+
+	std::unique_ptr<XenBackend::XenGnttabBuffer> mGnttabBuffer;
+
+	std::mutex mMutex;
+};
+
+/***************************************************************************//**
+ * Keeps mapped lazy grant table buffers in LRU order.
+ * Buffers which are not used longer than cIdleTimeoutMs are unmapped. If the
+ * limit of mapped bytes per domain is set, least recently used buffers of the
+ * domain are unmapped to fit a newly mapped one.
+ * @ingroup displ_be
+ ******************************************************************************/
+class GnttabMapCache
+{
+public:
+
+	GnttabMapCache(const GnttabMapCache&) = delete;
+	void operator=(const GnttabMapCache&) = delete;
+
+	static GnttabMapCache& getInstance();
+
+	/**
+	 * Sets the limit of mapped bytes per domain
+	 * @param limit limit in bytes, 0 - no limit
+	 */
+	void setDomainLimit(size_t limit);
+
+private:
+
+	friend class LazyGnttabBuffer;
+
+	const uint32_t cIdleTimeoutMs = 10000;
+	const uint32_t cCheckPeriodMs = 1000;
+
+	GnttabMapCache();
+	~GnttabMapCache();
+
+	size_t mDomainLimit;
+	bool mTerminate;
+	uint64_t mIdleUnmapCount;
+	uint64_t mLimitUnmapCount;
+	XenBackend::Log mLog;
+
+	// most recently used first
+	std::list<LazyGnttabBuffer*> mBuffers;
+	std::unordered_map<domid_t, size_t> mMappedBytes;
+
+	std::mutex mMutex;
+	std::condition_variable mCondVar;
+	std::thread mThread;
+
+	void onMapped(LazyGnttabBuffer* buffer);
+	void onUsed(LazyGnttabBuffer* buffer);
+	void remove(LazyGnttabBuffer* buffer);
+
+	bool unmap(LazyGnttabBuffer* buffer);
+	void unmapIdle();
+	void run();
+};
+
+#endif /* SRC_LAZY_GNTTAB_BUFFER_HPP_ */
@@ -31,84 +31,87 @@ using std::min;
 
 using XenBackend::XenGnttabBuffer;
 
-void pgDirGetBufferRefs(domid_t domId, grant_ref_t startDirectory,
-						uint32_t size, GrantRefs& refs)
+/*
+ * Walks the page directory chain and calls the handler for each directory
+ * page with the number of grefs it holds.
+ * The directory is a linked list: the reference of the next page is known
+ * only once the current one is mapped, so the pages can't be mapped in one
+ * batch. Each page is mapped with the access the handler needs only.
+ */
+template<typename Handler>
+static void pgDirWalk(domid_t domId, grant_ref_t startDirectory,
+					  uint32_t size, int prot, Handler handler)
 {
 	XenBackend::Log log("PgDirSharedBuffer");
 
-	refs.clear();
-
 	size_t requestedNumGrefs = (size + XC_PAGE_SIZE - 1) / XC_PAGE_SIZE;
+	size_t numPages = 0;
 
-	DLOG(log, DEBUG) << "Get buffer refs, directory: " << startDirectory
-					  << ", size: " << size
-					  << ", in grefs: " << requestedNumGrefs;
+	const size_t maxNumGrefs = (XC_PAGE_SIZE -
+								offsetof(xendispl_page_directory, gref)) /
+							   sizeof(uint32_t);
 
 	while(startDirectory != 0 && requestedNumGrefs)
 	{
-		DLOG(log, DEBUG) << "startDirectory: " << startDirectory;
-
-		XenGnttabBuffer pageBuffer(domId, startDirectory);
+		XenGnttabBuffer pageBuffer(domId, startDirectory, prot);
 
 		xendispl_page_directory* pageDirectory =
 				static_cast<xendispl_page_directory*>(pageBuffer.get());
 
-		size_t numGrefs = min(requestedNumGrefs, (XC_PAGE_SIZE -
-							  offsetof(xendispl_page_directory, gref)) /
-							  sizeof(uint32_t));
-
-		DLOG(log, DEBUG) << "Gref address: " << pageDirectory->gref
-						  << ", numGrefs " << numGrefs;
+		size_t numGrefs = min(requestedNumGrefs, maxNumGrefs);
 
-		refs.insert(refs.end(), pageDirectory->gref,
-					pageDirectory->gref + numGrefs);
+		handler(pageDirectory, numGrefs);
 
 		requestedNumGrefs -= numGrefs;
+		numPages++;
 
 		startDirectory = pageDirectory->gref_dir_next_page;
 	}
 
-	DLOG(log, DEBUG) << "Get buffer refs, num refs: " << refs.size();
+	DLOG(log, DEBUG) << "Walk directory, pages: " << numPages
+					 << ", grefs left: " << requestedNumGrefs;
 }
 
-void pgDirSetBufferRefs(domid_t domId, grant_ref_t startDirectory,
+void pgDirGetBufferRefs(domid_t domId, grant_ref_t startDirectory,
 						uint32_t size, GrantRefs& refs)
 {
 	XenBackend::Log log("PgDirSharedBuffer");
 
-	size_t requestedNumGrefs = (size + XC_PAGE_SIZE - 1) / XC_PAGE_SIZE;
-
-	DLOG(log, DEBUG) << "Set buffer refs, directory: " << startDirectory
-					  << ", size: " << size
-					  << ", in grefs: " << requestedNumGrefs;
-
-	grant_ref_t *grefs = refs.data();
-
-	while(startDirectory != 0 && requestedNumGrefs)
-	{
-		DLOG(log, DEBUG) << "startDirectory: " << startDirectory;
+	refs.clear();
+	refs.reserve((size + XC_PAGE_SIZE - 1) / XC_PAGE_SIZE);
 
-		XenGnttabBuffer pageBuffer(domId, startDirectory);
+	DLOG(log, DEBUG) << "Get buffer refs, directory: " << startDirectory
+					 << ", size: " << size
+					 << ", in grefs: " << refs.capacity();
 
-		xendispl_page_directory* pageDirectory =
-				static_cast<xendispl_page_directory*>(pageBuffer.get());
+	pgDirWalk(domId, startDirectory, size, PROT_READ,
+			  [&refs](xendispl_page_directory* pageDirectory, size_t numGrefs)
+			  {
+				  refs.insert(refs.end(), pageDirectory->gref,
+							  pageDirectory->gref + numGrefs);
+			  });
 
-		size_t numGrefs = min(requestedNumGrefs, (XC_PAGE_SIZE -
-							  offsetof(xendispl_page_directory, gref)) /
-							  sizeof(uint32_t));
+	DLOG(log, DEBUG) << "Get buffer refs, num refs: " << refs.size();
+}
 
-		DLOG(log, DEBUG) << "Gref address: " << pageDirectory->gref
-						  << ", numGrefs " << numGrefs;
+void pgDirSetBufferRefs(domid_t domId, grant_ref_t startDirectory,
+						uint32_t size, GrantRefs& refs)
+{
+	XenBackend::Log log("PgDirSharedBuffer");
 
-		memcpy(pageDirectory->gref, grefs, numGrefs * sizeof(grant_ref_t));
+	DLOG(log, DEBUG) << "Set buffer refs, directory: " << startDirectory
+					 << ", size: " << size;
 
-		requestedNumGrefs -= numGrefs;
-		grefs += numGrefs;
+	grant_ref_t *grefs = refs.data();
 
-		DLOG(log, DEBUG) << "requestedNumGrefs left: " << requestedNumGrefs;
+	pgDirWalk(domId, startDirectory, size, PROT_READ | PROT_WRITE,
+			  [&grefs](xendispl_page_directory* pageDirectory, size_t numGrefs)
+			  {
+				  memcpy(pageDirectory->gref, grefs,
+						 numGrefs * sizeof(grant_ref_t));
 
-		startDirectory = pageDirectory->gref_dir_next_page;
-	}
+				  grefs += numGrefs;
+			  });
 
 	DLOG(log, DEBUG) << "Set buffer refs, num refs: " << refs.size();
 }
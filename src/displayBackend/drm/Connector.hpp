@@ -73,6 +73,13 @@ public:
 	 */
 	bool isInitialized() const override { return mCrtcId != cInvalidId; }
 
+	/**
+	 * Checks if the connector is visible. DPMS is not tracked, so the
+	 * connector is visible once initialized
+	 * @return <i>true</i> if visible
+	 */
+	bool isVisible() const override { return isInitialized(); }
+
 	/**
 	 * Initializes CRTC mode
 	 * @param width       width
@@ -21,6 +21,8 @@
 
 #include "Dumb.hpp"
 
+#include <mutex>
+
 #include <sys/mman.h>
 
 #include <xf86drm.h>
@@ -34,9 +36,9 @@
 
 #include "Exception.hpp"
 
+using std::lock_guard;
 using std::string;
 
-using XenBackend::XenGnttabBuffer;
 using XenBackend::XenGnttabDmaBufferImporter;
 
 namespace Drm {
@@ -150,6 +152,9 @@ void DumbDrm::copy()
 	}
 
 	DLOG(mLog, DEBUG) << "Copy dumb, handle: " << mBufDrmHandle;
+
+	lock_guard<LazyGnttabBuffer> lock(*mGnttabBuffer);
+
 	if (mGnttabBuffer->size() == mSize)
 	{
 		memcpy(mBuffer, mGnttabBuffer->get(), mSize);
@@ -192,11 +197,11 @@ void DumbDrm::mapDumb()
 void DumbDrm::init(uint32_t bpp, size_t offset,
 				   domid_t domId, const GrantRefs& refs)
 {
+	// the grant buffer is mapped on first copy
+
 	if (refs.size())
 	{
-		mGnttabBuffer.reset(
-				new XenGnttabBuffer(domId, refs.data(), refs.size(),
-									PROT_READ | PROT_WRITE, offset));
+		mGnttabBuffer.reset(new LazyGnttabBuffer(domId, refs, offset));
 	}
 
 	createDumb(bpp);
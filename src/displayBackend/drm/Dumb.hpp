@@ -22,10 +22,13 @@
 #ifndef SRC_DRM_DUMB_HPP_
 #define SRC_DRM_DUMB_HPP_
 
+#include <memory>
+
 #include <xen/be/Log.hpp>
 #include <xen/be/XenGnttab.hpp>
 
 #include "DisplayItf.hpp"
+#include "LazyGnttabBuffer.hpp"
 
 namespace Drm {
 
@@ -145,7 +148,7 @@ private:
 
 	void* mBuffer;
 
-	std::unique_ptr<XenBackend::XenGnttabBuffer> mGnttabBuffer;
+	std::unique_ptr<LazyGnttabBuffer> mGnttabBuffer;
 
 	void mapDumb();
 
@@ -33,9 +33,11 @@ namespace Wayland {
 
 Connector::Connector(domid_t domId, const std::string& name,
 					 CompositorPtr compositor,
+					 ViewporterPtr viewporter,
 					 uint32_t width, uint32_t height) :
 	ConnectorBase(domId, width, height),
 	mCompositor(compositor),
+	mViewporter(viewporter),
 	mName(name)
 {
 	LOG(mLog, DEBUG) << "Create, name: "  << mName;
@@ -93,8 +95,25 @@ void Connector::onInit(SurfacePtr surface, FrameBufferPtr frameBuffer)
 
 	mSurface = surface;
 
+	// Scale the guest frame to the configured connector resolution on the
+	// compositor side
+
+	if (mViewporter)
+	{
+		mViewport = mViewporter->createViewport(mSurface);
+
+		mViewport->setDestination(mCfgWidth, mCfgHeight);
+	}
+
 	SurfaceManager::getInstance().createSurface(mName, mSurface->mWlSurface);
 
+	mSurface->setActiveCallback([this]()
+	{
+		onVisible();
+
+		mSurface->redraw();
+	});
+
 	mSurface->draw(frameBuffer);
 }
 
@@ -104,8 +123,11 @@ void Connector::onRelease()
 
 	if (mSurface)
 	{
+		mSurface->setActiveCallback(nullptr);
+
 		SurfaceManager::getInstance().deleteSurface(mName, mSurface->mWlSurface);
 
+		mViewport.reset();
 		mSurface.reset();
 	}
 }
@@ -32,6 +32,7 @@
 #endif
 #include "Shell.hpp"
 #include "ShellSurface.hpp"
+#include "Viewporter.hpp"
 
 namespace Wayland {
 
@@ -62,6 +63,15 @@ public:
 	 */
 	bool isInitialized() const override { return mSurface != nullptr; }
 
+	/**
+	 * Checks if the connector surface is displayed by the compositor
+	 * @return <i>true</i> if visible
+	 */
+	bool isVisible() const override
+	{
+		return mSurface && mSurface->isActive();
+	}
+
 	/**
 	 * Initializes connector
 	 * @param width       width
@@ -87,6 +97,7 @@ public:
 protected:
 
 	CompositorPtr mCompositor;
+	ViewporterPtr mViewporter;
 
 	void onInit(SurfacePtr surface, DisplayItf::FrameBufferPtr frameBuffer);
 	void onRelease();
@@ -98,11 +109,12 @@ private:
 	friend class IviConnector;
 
 	Connector(domid_t domId, const std::string& name, CompositorPtr compositor,
-			  uint32_t width, uint32_t height);
+			  ViewporterPtr viewporter, uint32_t width, uint32_t height);
 
 	std::string mName;
 
 	SurfacePtr mSurface;
+	ViewportPtr mViewport;
 };
 
 /***************************************************************************//**
@@ -146,8 +158,9 @@ private:
 	friend class Display;
 
 	ShellConnector(domid_t domId, const std::string& name, ShellPtr shell,
-				   CompositorPtr compositor, uint32_t width, uint32_t height) :
-		Connector(domId, name, compositor, width, height),
+				   CompositorPtr compositor, ViewporterPtr viewporter,
+				   uint32_t width, uint32_t height) :
+		Connector(domId, name, compositor, viewporter, width, height),
 		mShell(shell) {}
 
 	ShellPtr mShell;
@@ -196,8 +209,9 @@ private:
 
 	IviConnector(domid_t domId, const std::string& name,
 				 IviApplicationPtr iviApplication, CompositorPtr compositor,
-				 uint32_t surfaceId, uint32_t width, uint32_t height) :
-		Connector(domId, name, compositor, width, height),
+				 ViewporterPtr viewporter, uint32_t surfaceId,
+				 uint32_t width, uint32_t height) :
+		Connector(domId, name, compositor, viewporter, width, height),
 		mIviApplication(iviApplication),
 		mSurfaceId(surfaceId) {}
 
@@ -21,11 +21,14 @@
 
 #include "Display.hpp"
 
+#include <algorithm>
+
 #include <signal.h>
 
 #include "Exception.hpp"
 
 using std::lock_guard;
+using std::min;
 using std::mutex;
 using std::string;
 using std::thread;
@@ -106,7 +109,7 @@ void Display::flush()
 {
 	int result = 0;
 
-	while((result = wl_display_flush(mWlDisplay) < 0) && (errno == EAGAIN));
+	while(((result = wl_display_flush(mWlDisplay)) < 0) && (errno == EAGAIN));
 
 	if (result < 0)
 	{
@@ -138,7 +141,7 @@ DisplayItf::ConnectorPtr Display::createConnector(domid_t domId,
 		}
 
 		connector = new IviConnector(domId, name, mIviApplication, mCompositor,
-									 surfaceId, width, height);
+									 mViewporter, surfaceId, width, height);
 
 		LOG(mLog, DEBUG) << "Create ivi connector, name: " << name;
 	}
@@ -147,13 +150,14 @@ DisplayItf::ConnectorPtr Display::createConnector(domid_t domId,
 	if (mShell)
 	{
 		connector = new ShellConnector(domId, name, mShell, mCompositor,
-									   width, height);
+									   mViewporter, width, height);
 
 		LOG(mLog, DEBUG) << "Create shell connector, name: " << name;
 	}
 	else
 	{
-		connector = new Connector(domId, name, mCompositor, width, height);
+		connector = new Connector(domId, name, mCompositor, mViewporter,
+								  width, height);
 
 		LOG(mLog, DEBUG) << "Create connector, name: " << name;
 	}
@@ -438,6 +442,11 @@ void Display::registryHandler(wl_registry *registry, uint32_t id,
 	{
 		mSharedMemory.reset(new SharedMemory(registry, id, version));
 	}
+
+	if (interface == "wp_viewporter")
+	{
+		mViewporter.reset(new Viewporter(registry, id, version));
+	}
 #ifdef WITH_IVI_EXTENSION
 	if (interface == "ivi_application")
 	{
@@ -447,7 +456,14 @@ void Display::registryHandler(wl_registry *registry, uint32_t id,
 #ifdef WITH_INPUT
 	if (interface == "wl_seat")
 	{
-		mSeat.reset(new Seat(registry, id, Seat::cVersion));
+		mSeat.reset(new Seat(mWlDisplay, registry, id,
+							 min(version, Seat::cVersion)));
+	}
+
+	if (interface == "zwp_relative_pointer_manager_v1")
+	{
+		mRelativePointerManager.reset(
+				new RelativePointerManager(registry, id, version));
 	}
 #endif
 #ifdef WITH_ZCOPY
@@ -507,6 +523,15 @@ void Display::init()
 	{
 		throw Exception("Can't get compositor", ENOENT);
 	}
+#ifdef WITH_INPUT
+	// globals may come in any order, so the seat gets the relative pointer
+	// manager when all of them are bound
+
+	if (mSeat && mRelativePointerManager)
+	{
+		mSeat->setRelativePointerManager(mRelativePointerManager);
+	}
+#endif
 }
 
 void Display::release()
@@ -518,10 +543,12 @@ void Display::release()
 	mIviApplication.reset();
 #endif
 	mShell.reset();
+	mViewporter.reset();
 	mSharedMemory.reset();
 	mCompositor.reset();
 #ifdef WITH_INPUT
 	mSeat.reset();
+	mRelativePointerManager.reset();
 #endif
 #ifdef WITH_ZCOPY
 	mWaylandDrm.reset();
@@ -597,6 +624,10 @@ void Display::dispatchThread()
 			}
 			else
 			{
+				// don't block other threads reading the display
+
+				wl_display_cancel_read(mWlDisplay);
+
 				terminate = true;
 			}
 		}
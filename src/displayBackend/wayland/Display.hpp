@@ -39,6 +39,7 @@
 #endif
 #include "SharedMemory.hpp"
 #include "Shell.hpp"
+#include "Viewporter.hpp"
 #ifdef WITH_ZCOPY
 #include "WaylandZCopy.hpp"
 #endif
@@ -145,6 +146,7 @@ private:
 	CompositorPtr mCompositor;
 	ShellPtr mShell;
 	SharedMemoryPtr mSharedMemory;
+	ViewporterPtr mViewporter;
 
 #ifdef WITH_IVI_EXTENSION
 	IviApplicationPtr mIviApplication;
@@ -152,6 +154,7 @@ private:
 
 #ifdef WITH_INPUT
 	SeatPtr mSeat;
+	RelativePointerManagerPtr mRelativePointerManager;
 #endif
 
 #ifdef WITH_ZCOPY
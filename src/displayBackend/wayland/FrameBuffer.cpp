@@ -81,14 +81,6 @@ void WlBuffer::setListener()
 	}
 }
 
-/*******************************************************************************
- * Private
- ******************************************************************************/
-void WlBuffer::sOnRelease(void *data, wl_buffer *wlBuffer)
-{
-	static_cast<WlBuffer*>(data)->onRelease();
-}
-
 void WlBuffer::onRelease()
 {
 	lock_guard<mutex> lock(mMutex);
@@ -98,6 +90,13 @@ void WlBuffer::onRelease()
 	mSurface = nullptr;
 }
 
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+void WlBuffer::sOnRelease(void *data, wl_buffer *wlBuffer)
+{
+	static_cast<WlBuffer*>(data)->onRelease();
+}
 
 void WlBuffer::setSurface(Surface* surface)
 {
@@ -109,68 +108,119 @@ void WlBuffer::setSurface(Surface* surface)
 /*******************************************************************************
  * SharedBuffer
  ******************************************************************************/
-SharedBuffer::SharedBuffer(wl_shm* wlSharedMemory,
-						   DisplayBufferPtr displayBuffer,
+SharedBuffer::SharedBuffer(SharedFilePtr sharedFile,
 						   uint32_t width, uint32_t height,
 						   uint32_t pixelFormat) :
-	WlBuffer(displayBuffer, width, height),
-	mWlPool(nullptr)
+	WlBuffer(sharedFile, width, height),
+	mSharedFile(sharedFile),
+	mPixelFormat(pixelFormat),
+	mShadowWlBuffer(nullptr)
 {
-	try
-	{
-		init(wlSharedMemory, pixelFormat);
-	}
-	catch(const std::exception& e)
-	{
-		release();
+	mWlBuffer = createWlBuffer(SharedFile::PRIMARY_RANGE);
 
-		throw;
-	}
+	setListener();
+
+	mShadowListener = {sOnShadowRelease};
 }
 
 SharedBuffer::~SharedBuffer()
 {
-	release();
+	if (mShadowWlBuffer)
+	{
+		wl_buffer_destroy(mShadowWlBuffer);
+
+		LOG(mLog, DEBUG) << "Delete shadow";
+	}
 }
 
-void SharedBuffer::init(wl_shm* wlSharedMemory, uint32_t pixelFormat)
-{
-	mWlPool = wl_shm_create_pool(wlSharedMemory, mDisplayBuffer->getFd(),
-							   mHeight * mDisplayBuffer->getStride());
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
 
-	if (!mWlPool)
+uintptr_t SharedBuffer::getHandle() const
+{
+	if (mSharedFile->getAttachedRange() == SharedFile::SHADOW_RANGE)
 	{
-		throw Exception("Can't create pool", errno);
+		return reinterpret_cast<uintptr_t>(mShadowWlBuffer);
 	}
 
-	mWlBuffer = wl_shm_pool_create_buffer(mWlPool, 0, mWidth, mHeight,
-										  mDisplayBuffer->getStride(),
-										  pixelFormat);
+	return reinterpret_cast<uintptr_t>(mWlBuffer);
+}
 
-	if (!mWlBuffer)
+void SharedBuffer::setSurface(Surface* surface)
+{
+	if (surface)
 	{
-		throw Exception("Can't create shared buffer", errno);
+		// called right before attach: choose the wl buffer to attach
+
+		// the range is attached and marked busy under the shared file lock,
+		// the release callbacks check it from the wayland thread
+
+		auto range = mSharedFile->attachCurrentRange();
+
+		if (range == SharedFile::SHADOW_RANGE && !mShadowWlBuffer)
+		{
+			mShadowWlBuffer = createWlBuffer(SharedFile::SHADOW_RANGE);
+
+			if (wl_buffer_add_listener(mShadowWlBuffer,
+									   &mShadowListener, this) < 0)
+			{
+				throw Exception("Can't add listener", errno);
+			}
+		}
 	}
 
-	setListener();
+	WlBuffer::setSurface(surface);
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+wl_buffer* SharedBuffer::createWlBuffer(int range)
+{
+	auto poolOffset = mSharedFile->getRangeOffset(range);
 
-	wl_shm_pool_destroy(mWlPool);
+	auto wlBuffer = wl_shm_pool_create_buffer(
+			mSharedFile->mPool->getWlPool(), poolOffset, mWidth, mHeight,
+			mDisplayBuffer->getStride(), mPixelFormat);
 
-	mWlPool = nullptr;
+	if (!wlBuffer)
+	{
+		throw Exception("Can't create shared buffer", errno);
+	}
 
 	LOG(mLog, DEBUG) << "Create shared buffer, w: " << mWidth
 					 << ", h: " << mHeight
 					 << ", stride: " << mDisplayBuffer->getStride()
 					 << ", fd: " << mDisplayBuffer->getFd()
+					 << ", pool offset: " << poolOffset
 					 << ", format: 0x"  << hex << setfill('0') << setw(8)
-					 << pixelFormat;
+					 << mPixelFormat;
+
+	return wlBuffer;
+}
+
+void SharedBuffer::onRelease()
+{
+	if (mSharedFile->releaseRange(SharedFile::PRIMARY_RANGE))
+	{
+		WlBuffer::onRelease();
+	}
 }
 
-void SharedBuffer::release()
+void SharedBuffer::sOnShadowRelease(void *data, wl_buffer *wlBuffer)
 {
-	if (mWlPool)
+	static_cast<SharedBuffer*>(data)->onShadowRelease();
+}
+
+void SharedBuffer::onShadowRelease()
+{
+	DLOG(mLog, DEBUG) << "Release shadow";
+
+	if (mSharedFile->releaseRange(SharedFile::SHADOW_RANGE))
 	{
-		wl_shm_pool_destroy(mWlPool);
+		WlBuffer::onRelease();
 	}
 }
 
@@ -28,6 +28,7 @@
 
 #include <xen/be/Log.hpp>
 
+#include "SharedFile.hpp"
 #include "Surface.hpp"
 
 #include "DisplayItf.hpp"
@@ -76,7 +77,7 @@ public:
 		return mDisplayBuffer;
 	}
 
-	void setSurface(Surface* surface);
+	virtual void setSurface(Surface* surface);
 
 protected:
 
@@ -91,6 +92,8 @@ protected:
 
 	void setListener();
 
+	virtual void onRelease();
+
 private:
 
 	wl_buffer_listener mWlListener;
@@ -100,11 +103,13 @@ private:
 	std::mutex mMutex;
 
 	static void sOnRelease(void *data, wl_buffer *wlBuffer);
-	void onRelease();
 };
 
 /***************************************************************************//**
  * Shared buffer class.
+ * Tracks which range of the shared file is held by the compositor. When the
+ * shared file switches to its shadow range, the buffer attaches a second
+ * wl_buffer created over that range.
  * @ingroup wayland
  ******************************************************************************/
 class SharedBuffer : public WlBuffer
@@ -113,19 +118,30 @@ public:
 
 	~SharedBuffer();
 
+	/**
+	 * Gets handle of the wl buffer of the current shared file range
+	 */
+	uintptr_t getHandle() const override;
+
+	void setSurface(Surface* surface) override;
+
 private:
 
 	friend class SharedMemory;
 
-	SharedBuffer(wl_shm* wlSharedMemory,
-				 DisplayItf::DisplayBufferPtr displayBuffer,
-				 uint32_t width, uint32_t height,
+	SharedBuffer(SharedFilePtr sharedFile, uint32_t width, uint32_t height,
 				 uint32_t pixelFormat);
 
-	wl_shm_pool* mWlPool;
+	SharedFilePtr mSharedFile;
+	uint32_t mPixelFormat;
+	wl_buffer* mShadowWlBuffer;
+	wl_buffer_listener mShadowListener;
+
+	wl_buffer* createWlBuffer(int range);
+	void onRelease() override;
 
-	void init(wl_shm* wlSharedMemory, uint32_t pixelFormat);
-	void release();
+	static void sOnShadowRelease(void *data, wl_buffer *wlBuffer);
+	void onShadowRelease();
 };
 
 typedef std::shared_ptr<SharedBuffer> SharedBufferPtr;
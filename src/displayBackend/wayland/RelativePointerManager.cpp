@@ -0,0 +1,118 @@
+/*
+ *  Wayland relative pointer manager
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "RelativePointerManager.hpp"
+
+#include "Exception.hpp"
+
+namespace Wayland {
+
+/*******************************************************************************
+ * RelativePointerManager
+ ******************************************************************************/
+
+RelativePointerManager::RelativePointerManager(wl_registry* registry,
+											   uint32_t id, uint32_t version) :
+	Registry(registry, id, version),
+	mWpRelativePointerManager(nullptr),
+	mLog("RelativePointerManager")
+{
+	try
+	{
+		init();
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+RelativePointerManager::~RelativePointerManager()
+{
+	release();
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+zwp_relative_pointer_v1* RelativePointerManager::createRelativePointer(
+		wl_pointer* pointer, wl_event_queue* queue)
+{
+	// the manager is bound on the display queue, the relative pointer
+	// inherits the queue of the wrapper it is created with
+
+	auto manager = static_cast<zwp_relative_pointer_manager_v1*>(
+			wl_proxy_create_wrapper(mWpRelativePointerManager));
+
+	if (!manager)
+	{
+		throw Exception("Can't create relative pointer manager wrapper",
+						errno);
+	}
+
+	wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(manager), queue);
+
+	auto relativePointer =
+			zwp_relative_pointer_manager_v1_get_relative_pointer(manager,
+																 pointer);
+
+	wl_proxy_wrapper_destroy(manager);
+
+	if (!relativePointer)
+	{
+		throw Exception("Can't create relative pointer", errno);
+	}
+
+	LOG(mLog, DEBUG) << "Create relative pointer";
+
+	return relativePointer;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void RelativePointerManager::init()
+{
+	mWpRelativePointerManager = static_cast<zwp_relative_pointer_manager_v1*>(
+			bind(&zwp_relative_pointer_manager_v1_interface));
+
+	if (!mWpRelativePointerManager)
+	{
+		throw Exception("Can't bind relative pointer manager", errno);
+	}
+
+	LOG(mLog, DEBUG) << "Create";
+}
+
+void RelativePointerManager::release()
+{
+	if (mWpRelativePointerManager)
+	{
+		zwp_relative_pointer_manager_v1_destroy(mWpRelativePointerManager);
+
+		LOG(mLog, DEBUG) << "Delete";
+	}
+}
+
+}
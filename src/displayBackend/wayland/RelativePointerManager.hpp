@@ -0,0 +1,70 @@
+/*
+ *  Wayland relative pointer manager
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_WAYLAND_RELATIVEPOINTERMANAGER_HPP_
+#define SRC_WAYLAND_RELATIVEPOINTERMANAGER_HPP_
+
+#include <memory>
+
+#include <xen/be/Log.hpp>
+
+#include "Registry.hpp"
+#include "relative-pointer-unstable-v1-client-protocol.h"
+
+namespace Wayland {
+
+/***************************************************************************//**
+ * Wayland relative pointer manager class.
+ * Provides relative pointers which report unaccelerated pointer deltas.
+ * @ingroup wayland
+ ******************************************************************************/
+class RelativePointerManager : public Registry
+{
+public:
+
+	~RelativePointerManager();
+
+	/**
+	 * Creates relative pointer, the caller is responsible to destroy it
+	 * @param pointer wl pointer
+	 * @param queue   event queue to deliver relative pointer events
+	 */
+	zwp_relative_pointer_v1* createRelativePointer(wl_pointer* pointer,
+												   wl_event_queue* queue);
+
+private:
+
+	friend class Display;
+
+	RelativePointerManager(wl_registry* registry, uint32_t id,
+						   uint32_t version);
+
+	zwp_relative_pointer_manager_v1* mWpRelativePointerManager;
+	XenBackend::Log mLog;
+
+	void init();
+	void release();
+};
+
+typedef std::shared_ptr<RelativePointerManager> RelativePointerManagerPtr;
+
+}
+
+#endif /* SRC_WAYLAND_RELATIVEPOINTERMANAGER_HPP_ */
@@ -12,6 +12,9 @@
 using std::lock_guard;
 using std::mutex;
 using std::string;
+using std::thread;
+
+using XenBackend::PollFd;
 
 using InputItf::KeyboardCallbacks;
 using InputItf::PointerCallbacks;
@@ -23,8 +26,11 @@ namespace Wayland {
  * Seat
  ******************************************************************************/
 
-Seat::Seat(wl_registry* registry, uint32_t id, uint32_t version) :
+Seat::Seat(wl_display* display, wl_registry* registry,
+		   uint32_t id, uint32_t version) :
 	Registry(registry, id, version),
+	mWlDisplay(display),
+	mWlEventQueue(nullptr),
 	mWlSeat(nullptr),
 	mLog("Seat")
 {
@@ -106,6 +112,8 @@ void Seat::readCapabilities(uint32_t capabilities)
 		if (!mSeatPointer)
 		{
 			mSeatPointer.reset(new SeatPointer(mWlSeat));
+
+			setRelativePointer();
 		}
 	}
 
@@ -125,9 +133,66 @@ void Seat::readName(const std::string& name)
 	LOG(mLog, DEBUG) << "Name: " << name;
 }
 
+void Seat::setRelativePointerManager(RelativePointerManagerPtr manager)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mRelativePointerManager = manager;
+
+	if (mSeatPointer)
+	{
+		setRelativePointer();
+	}
+}
+
+void Seat::setRelativePointer()
+{
+	if (!mRelativePointerManager)
+	{
+		return;
+	}
+
+	// pointer works without relative motion if it can't be created
+
+	try
+	{
+		mSeatPointer->setRelativePointer(
+				mRelativePointerManager->createRelativePointer(
+						mSeatPointer->mWlPointer, mWlEventQueue));
+	}
+	catch(const std::exception& e)
+	{
+		LOG(mLog, ERROR) << e.what();
+	}
+}
+
 void Seat::init()
 {
-	mWlSeat = static_cast<wl_seat*>(bind(&wl_seat_interface));
+	mWlEventQueue = wl_display_create_queue(mWlDisplay);
+
+	if (!mWlEventQueue)
+	{
+		throw Exception("Can't create event queue", errno);
+	}
+
+	// Objects created by the seat inherit its queue, so binding the seat
+	// through the registry wrapper moves all input events to the queue
+
+	auto registry = static_cast<wl_registry*>(
+			wl_proxy_create_wrapper(getRegistry()));
+
+	if (!registry)
+	{
+		throw Exception("Can't create registry wrapper", errno);
+	}
+
+	wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(registry), mWlEventQueue);
+
+	mWlSeat = static_cast<wl_seat*>(wl_registry_bind(registry, getId(),
+													 &wl_seat_interface,
+													 getVersion()));
+
+	wl_proxy_wrapper_destroy(registry);
 
 	if (!mWlSeat)
 	{
@@ -141,17 +206,87 @@ void Seat::init()
 		throw Exception("Can't add listener", errno);
 	}
 
+	// Get capabilities before the devices are requested
+
+	if (wl_display_roundtrip_queue(mWlDisplay, mWlEventQueue) < 0)
+	{
+		throw Exception("Can't get seat capabilities", errno);
+	}
+
+	mPollFd.reset(new PollFd(wl_display_get_fd(mWlDisplay), POLLIN));
+
+	mThread = thread(&Seat::dispatchThread, this);
+
 	LOG(mLog, DEBUG) << "Create";
 }
 
 void Seat::release()
 {
+	if (mPollFd)
+	{
+		mPollFd->stop();
+	}
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	mSeatKeyboard.reset();
+	mSeatPointer.reset();
+	mSeatTouch.reset();
+	mRelativePointerManager.reset();
+
 	if (mWlSeat)
 	{
 		wl_seat_destroy(mWlSeat);
 
 		LOG(mLog, DEBUG) << "Delete";
 	}
+
+	if (mWlEventQueue)
+	{
+		wl_event_queue_destroy(mWlEventQueue);
+	}
+}
+
+void Seat::dispatchThread()
+{
+	try
+	{
+		while(true)
+		{
+			while (wl_display_prepare_read_queue(mWlDisplay,
+												 mWlEventQueue) != 0)
+			{
+				auto val = wl_display_dispatch_queue_pending(mWlDisplay,
+															 mWlEventQueue);
+
+				if (val < 0)
+				{
+					throw Exception("Can't dispatch input events", errno);
+				}
+
+				DLOG(mLog, DEBUG) << "Dispatch input events: " << val;
+			}
+
+			if (!mPollFd->poll())
+			{
+				wl_display_cancel_read(mWlDisplay);
+
+				break;
+			}
+
+			if (wl_display_read_events(mWlDisplay) < 0)
+			{
+				throw Exception("Can't read input events", errno);
+			}
+		}
+	}
+	catch(const std::exception& e)
+	{
+		LOG(mLog, ERROR) << e.what();
+	}
 }
 
 }
@@ -10,11 +10,14 @@
 
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #include <xen/be/Log.hpp>
+#include <xen/be/Utils.hpp>
 
 #include "Registry.hpp"
 #include "ShellSurface.hpp"
+#include "RelativePointerManager.hpp"
 #include "SeatKeyboard.hpp"
 #include "SeatPointer.hpp"
 #include "SeatTouch.hpp"
@@ -23,14 +26,17 @@ namespace Wayland {
 
 /***************************************************************************//**
  * Wayland seat class.
+ * Seat and its devices are bound on a dedicated event queue which is
+ * dispatched by own thread, so input events are not delayed by surface
+ * and buffer events processed by the display thread.
  * @ingroup wayland
  ******************************************************************************/
 class Seat : public Registry
 {
 public:
-	//  Wayland 1.11
-	//	static const int cVersion = 5;
-	static const int cVersion = 4;
+	// version 5 is required for wl_pointer.frame, version 6 for wl_touch
+	// shape and orientation
+	static const uint32_t cVersion = 6;
 
 	~Seat();
 
@@ -42,8 +48,11 @@ private:
 
 	friend class Display;
 
-	Seat(wl_registry* registry, uint32_t id, uint32_t version);
+	Seat(wl_display* display, wl_registry* registry,
+		 uint32_t id, uint32_t version);
 
+	wl_display* mWlDisplay;
+	wl_event_queue* mWlEventQueue;
 	wl_seat* mWlSeat;
 	XenBackend::Log mLog;
 
@@ -53,7 +62,12 @@ private:
 	SeatPointerPtr mSeatPointer;
 	SeatTouchPtr mSeatTouch;
 
+	RelativePointerManagerPtr mRelativePointerManager;
+
 	std::mutex mMutex;
+	std::thread mThread;
+
+	std::unique_ptr<XenBackend::PollFd> mPollFd;
 
 	static void sReadCapabilities(void* data, wl_seat* seat,
 								  uint32_t capabilities);
@@ -62,8 +76,13 @@ private:
 	void readCapabilities(uint32_t capabilities);
 	void readName(const std::string& name);
 
+	void setRelativePointerManager(RelativePointerManagerPtr manager);
+	void setRelativePointer();
+
 	void init();
 	void release();
+
+	void dispatchThread();
 };
 
 typedef std::shared_ptr<Seat> SeatPtr;
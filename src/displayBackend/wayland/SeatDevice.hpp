@@ -11,6 +11,9 @@
 #include <mutex>
 #include <unordered_map>
 
+#include <xen/be/Log.hpp>
+
+#include "InputLatency.hpp"
 #include "Surface.hpp"
 #include "SurfaceManager.hpp"
 
@@ -21,7 +24,13 @@ class SeatDevice : public SurfaceNotificationItf
 {
 public:
 
-	SeatDevice()
+	/**
+	 * @param name device name used for latency log
+	 */
+	SeatDevice(const std::string& name) :
+		mLatency(InputLatency::getInstance().getHistogram(name)),
+		mFrameTime(0),
+		mFrameStarted(false)
 	{
 		SurfaceManager::getInstance().subscribe(this);
 
@@ -70,8 +79,48 @@ protected:
 	std::unordered_map<std::string, T> mConnectorCallbacks;
 	CallbackIt mCurrentCallback;
 
+	/**
+	 * Starts a frame if not started yet, the frame latency is measured from
+	 * its first event
+	 * @param time compositor event timestamp in ms
+	 */
+	void startFrame(uint32_t time)
+	{
+		if (!mFrameStarted)
+		{
+			mFrameTime = time;
+			mFrameStarted = true;
+		}
+	}
+
+	/**
+	 * Measures latency of the started frame. Shall be called after the frame
+	 * callback.
+	 */
+	void measureLatency()
+	{
+		if (!mFrameStarted)
+		{
+			return;
+		}
+
+		mFrameStarted = false;
+
+		// compositor timestamps are ms of undefined base, the ones which are
+		// not based on the monotonic clock are skipped by the histogram
+
+		auto now = LatencyHistogram::now();
+		uint32_t latencyMs = static_cast<uint32_t>(now / 1000) - mFrameTime;
+
+		mLatency->addSince(now - latencyMs * 1000ull);
+	}
+
 private:
 
+	LatencyHistogramPtr mLatency;
+	uint32_t mFrameTime;
+	bool mFrameStarted;
+
 	void onSurfaceCreate(const std::string& connectorName,
 						 wl_surface* surface) override
 	{
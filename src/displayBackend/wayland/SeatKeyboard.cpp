@@ -21,6 +21,7 @@ namespace Wayland {
  ******************************************************************************/
 
 SeatKeyboard::SeatKeyboard(wl_seat* seat) :
+	SeatDevice("SeatKeyboard"),
 	mWlKeyboard(nullptr),
 	mLog("SeatKeyboard")
 {
@@ -120,7 +121,18 @@ void SeatKeyboard::onKey(uint32_t serial, uint32_t time,
 	if (mCurrentCallback != mSurfaceCallbacks.end() &&
 		mCurrentCallback->second.key)
 	{
+		startFrame(time);
+
 		mCurrentCallback->second.key(key, state);
+
+		// wl_keyboard has no frame event, each key is a frame
+
+		if (mCurrentCallback->second.frame)
+		{
+			mCurrentCallback->second.frame();
+		}
+
+		measureLatency();
 	}
 }
 
@@ -21,8 +21,15 @@ namespace Wayland {
  ******************************************************************************/
 
 SeatPointer::SeatPointer(wl_seat* seat) :
+	SeatDevice("SeatPointer"),
 	mWlPointer(nullptr),
-	mLog("SeatPointer")
+	mLog("SeatPointer"),
+	mHasFrames(false),
+	mWpRelativePointer(nullptr),
+	mLastX(0),
+	mLastY(0),
+	mRemainderX(0),
+	mRemainderY(0)
 {
 	try
 	{
@@ -81,7 +88,7 @@ void SeatPointer::sOnAxis(void* data, wl_pointer* pointer, uint32_t time,
 
 void SeatPointer::sOnFrame(void* data, struct wl_pointer* pointer)
 {
-
+	static_cast<SeatPointer*>(data)->onFrame();
 }
 
 void SeatPointer::sOnAxisSource(void* data, wl_pointer* pointer,
@@ -102,23 +109,33 @@ void SeatPointer::sOnAxisDiscrete(void* data, wl_pointer* pointer,
 
 }
 
+void SeatPointer::sOnRelativeMotion(void* data,
+									 zwp_relative_pointer_v1* relativePointer,
+									 uint32_t timeHi, uint32_t timeLo,
+									 wl_fixed_t dx, wl_fixed_t dy,
+									 wl_fixed_t dxUnaccel, wl_fixed_t dyUnaccel)
+{
+	static_cast<SeatPointer*>(data)->onRelativeMotion(
+			(static_cast<uint64_t>(timeHi) << 32) | timeLo,
+			dxUnaccel, dyUnaccel);
+}
+
 void SeatPointer::onEnter(uint32_t serial, wl_surface* surface,
 						  wl_fixed_t x, wl_fixed_t y)
 {
 	lock_guard<mutex> lock(mMutex);
 
-	int32_t resX = wl_fixed_to_int(x);
-	int32_t resY = wl_fixed_to_int(y);
-
 	DLOG(mLog, DEBUG) << "onEnter connector: "
 					  << SurfaceManager::getInstance().getConnectorNameBySurface(surface)
 					  << ", serial: " << serial
-					  << ", X: " << resX << ", Y: " << resY;
+					  << ", X: " << wl_fixed_to_double(x)
+					  << ", Y: " << wl_fixed_to_double(y);
 
 	mCurrentCallback = mSurfaceCallbacks.find(surface);
 
-	mLastX = resX;
-	mLastY = resY;
+	mLastX = x;
+	mLastY = y;
+	mRemainderX = mRemainderY = 0;
 }
 
 void SeatPointer::onLeave(uint32_t serial, wl_surface* surface)
@@ -129,6 +146,13 @@ void SeatPointer::onLeave(uint32_t serial, wl_surface* surface)
 					  << SurfaceManager::getInstance().getConnectorNameBySurface(surface)
 					  << ", serial: " << serial;
 
+	// events already received in this frame belong to the left surface
+
+	if (mHasFrames)
+	{
+		sendFrame();
+	}
+
 	mCurrentCallback = mSurfaceCallbacks.end();
 }
 
@@ -140,24 +164,33 @@ void SeatPointer::onMotion(uint32_t time, wl_fixed_t x, wl_fixed_t y)
 	int32_t resY = wl_fixed_to_int(y);
 
 	DLOG(mLog, DEBUG) << "onMotion time: " << time
-					  << ", X: " << resX << ", Y: " << resY;
+					  << ", X: " << wl_fixed_to_double(x)
+					  << ", Y: " << wl_fixed_to_double(y);
 
 	if (mCurrentCallback != mSurfaceCallbacks.end())
 	{
-		if (mCurrentCallback->second.moveRelative)
+		startFrame(time);
+
+		// unaccelerated deltas come from the relative pointer if it is set
+
+		if (!mWpRelativePointer)
 		{
-			mCurrentCallback->second.moveRelative(resX - mLastX,
-												  resY - mLastY, 0);
+			sendRelative(x - mLastX, y - mLastY);
 		}
 
 		if (mCurrentCallback->second.moveAbsolute)
 		{
 			mCurrentCallback->second.moveAbsolute(resX, resY, 0);
 		}
+
+		if (!mHasFrames)
+		{
+			sendFrame();
+		}
 	}
 
-	mLastX = resX;
-	mLastY = resY;
+	mLastX = x;
+	mLastY = y;
 }
 
 void SeatPointer::onButton(uint32_t serial, uint32_t time,
@@ -171,7 +204,14 @@ void SeatPointer::onButton(uint32_t serial, uint32_t time,
 	if (mCurrentCallback != mSurfaceCallbacks.end() &&
 		mCurrentCallback->second.button)
 	{
+		startFrame(time);
+
 		mCurrentCallback->second.button(button, state);
+
+		if (!mHasFrames)
+		{
+			sendFrame();
+		}
 	}
 }
 
@@ -187,10 +227,96 @@ void SeatPointer::onAxis(uint32_t time, uint32_t axis, wl_fixed_t value)
 	if (mCurrentCallback != mSurfaceCallbacks.end() &&
 		mCurrentCallback->second.moveRelative)
 	{
+		startFrame(time);
+
 		mCurrentCallback->second.moveRelative(0, 0, resValue);
+
+		if (!mHasFrames)
+		{
+			sendFrame();
+		}
+	}
+}
+
+void SeatPointer::onFrame()
+{
+	lock_guard<mutex> lock(mMutex);
+
+	DLOG(mLog, DEBUG) << "onFrame";
+
+	sendFrame();
+}
+
+void SeatPointer::onRelativeMotion(uint64_t time, wl_fixed_t dx, wl_fixed_t dy)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	DLOG(mLog, DEBUG) << "onRelativeMotion time: " << time
+					  << ", dX: " << wl_fixed_to_double(dx)
+					  << ", dY: " << wl_fixed_to_double(dy);
+
+	if (mCurrentCallback != mSurfaceCallbacks.end())
+	{
+		startFrame(static_cast<uint32_t>(time / 1000));
+
+		sendRelative(dx, dy);
+
+		if (!mHasFrames)
+		{
+			sendFrame();
+		}
 	}
 }
 
+void SeatPointer::sendRelative(wl_fixed_t dx, wl_fixed_t dy)
+{
+	// only whole units are sent, fractional parts are kept for next motions
+
+	mRemainderX += dx;
+	mRemainderY += dy;
+
+	int32_t relX = wl_fixed_to_int(mRemainderX);
+	int32_t relY = wl_fixed_to_int(mRemainderY);
+
+	mRemainderX -= wl_fixed_from_int(relX);
+	mRemainderY -= wl_fixed_from_int(relY);
+
+	if ((relX || relY) && mCurrentCallback->second.moveRelative)
+	{
+		mCurrentCallback->second.moveRelative(relX, relY, 0);
+	}
+}
+
+void SeatPointer::setRelativePointer(zwp_relative_pointer_v1* relativePointer)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mRelativeListener = { sOnRelativeMotion };
+
+	if (zwp_relative_pointer_v1_add_listener(relativePointer,
+											 &mRelativeListener, this))
+	{
+		zwp_relative_pointer_v1_destroy(relativePointer);
+
+		throw Exception("Can't add relative pointer listener", errno);
+	}
+
+	mWpRelativePointer = relativePointer;
+
+	LOG(mLog, DEBUG) << "Set relative pointer";
+}
+
+void SeatPointer::sendFrame()
+{
+	if (mCurrentCallback != mSurfaceCallbacks.end() &&
+		mCurrentCallback->second.frame)
+	{
+		mCurrentCallback->second.frame();
+	}
+
+	measureLatency();
+}
+
 void SeatPointer::init(wl_seat* seat)
 {
 	mWlPointer = wl_seat_get_pointer(seat);
@@ -200,23 +326,29 @@ void SeatPointer::init(wl_seat* seat)
 		throw Exception("Can't create pointer", errno);
 	}
 
-	// Wayland 1.11
-	// mListener = { sOnEnter, sOnLeave, sOnMotion, sOnButton, sOnAxis, sOnFrame,
-	//			  sOnAxisSource, sOnAxisStop, sOnAxisDiscrete };
-	//
+	mListener = { sOnEnter, sOnLeave, sOnMotion, sOnButton, sOnAxis, sOnFrame,
+				  sOnAxisSource, sOnAxisStop, sOnAxisDiscrete };
 
-	mListener = { sOnEnter, sOnLeave, sOnMotion, sOnButton, sOnAxis };
+	// without wl_pointer.frame each event is delivered as a frame
+
+	mHasFrames = wl_pointer_get_version(mWlPointer) >=
+				 WL_POINTER_FRAME_SINCE_VERSION;
 
 	if (wl_pointer_add_listener(mWlPointer, &mListener, this))
 	{
 		throw Exception("Can't add listener", errno);
 	}
 
-	LOG(mLog, DEBUG) << "Create";
+	LOG(mLog, DEBUG) << "Create, frames: " << mHasFrames;
 }
 
 void SeatPointer::release()
 {
+	if (mWpRelativePointer)
+	{
+		zwp_relative_pointer_v1_destroy(mWpRelativePointer);
+	}
+
 	if (mWlPointer)
 	{
 		wl_pointer_destroy(mWlPointer);
@@ -14,9 +14,18 @@
 
 #include "SeatDevice.hpp"
 #include "InputItf.hpp"
+#include "relative-pointer-unstable-v1-client-protocol.h"
 
 namespace Wayland {
 
+/***************************************************************************//**
+ * Wayland seat pointer.
+ * If the relative pointer is set, relative motion is taken from its
+ * unaccelerated deltas. Otherwise, it is the difference of surface positions.
+ * In both cases fractional parts are accumulated, so sub-pixel motion is not
+ * lost by rounding.
+ * @ingroup wayland
+ ******************************************************************************/
 class SeatPointer : public SeatDevice<InputItf::PointerCallbacks>
 {
 public:
@@ -32,9 +41,15 @@ private:
 	wl_pointer* mWlPointer;
 	wl_pointer_listener mListener;
 	XenBackend::Log mLog;
+	bool mHasFrames;
+
+	zwp_relative_pointer_v1* mWpRelativePointer;
+	zwp_relative_pointer_v1_listener mRelativeListener;
 
 	wl_fixed_t mLastX;
 	wl_fixed_t mLastY;
+	wl_fixed_t mRemainderX;
+	wl_fixed_t mRemainderY;
 
 	static void sOnEnter(void* data, wl_pointer* pointer, uint32_t serial,
 						 wl_surface* surface, wl_fixed_t x, wl_fixed_t y);
@@ -55,6 +70,12 @@ private:
 	static void sOnAxisDiscrete(void* data, wl_pointer* pointer,
 								uint32_t axis, int32_t discrete);
 
+	static void sOnRelativeMotion(void* data,
+								  zwp_relative_pointer_v1* relativePointer,
+								  uint32_t timeHi, uint32_t timeLo,
+								  wl_fixed_t dx, wl_fixed_t dy,
+								  wl_fixed_t dxUnaccel, wl_fixed_t dyUnaccel);
+
 	void onEnter(uint32_t serial, wl_surface* surface,
 				 wl_fixed_t x, wl_fixed_t y);
 	void onLeave(uint32_t serial, wl_surface* surface);
@@ -62,6 +83,13 @@ private:
 	void onButton(uint32_t serial, uint32_t time,
 				  uint32_t button, uint32_t state);
 	void onAxis(uint32_t time, uint32_t axis, wl_fixed_t value);
+	void onFrame();
+	void onRelativeMotion(uint64_t time, wl_fixed_t dx, wl_fixed_t dy);
+
+	void sendFrame();
+	void sendRelative(wl_fixed_t dx, wl_fixed_t dy);
+
+	void setRelativePointer(zwp_relative_pointer_v1* relativePointer);
 
 	void init(wl_seat* seat);
 	void release();
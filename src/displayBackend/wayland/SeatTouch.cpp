@@ -21,6 +21,7 @@ namespace Wayland {
  ******************************************************************************/
 
 SeatTouch::SeatTouch(wl_seat* seat) :
+	SeatDevice("SeatTouch"),
 	mWlTouch(nullptr),
 	mCurrentId(-1),
 	mLog("SeatTouch")
@@ -79,6 +80,18 @@ void SeatTouch::sOnCancel(void* data, wl_touch* touch)
 	static_cast<SeatTouch*>(data)->onCancel();
 }
 
+void SeatTouch::sOnShape(void* data, wl_touch* touch, int32_t id,
+						 wl_fixed_t major, wl_fixed_t minor)
+{
+	static_cast<SeatTouch*>(data)->onShape(id, major, minor);
+}
+
+void SeatTouch::sOnOrientation(void* data, wl_touch* touch, int32_t id,
+							   wl_fixed_t orientation)
+{
+	static_cast<SeatTouch*>(data)->onOrientation(id, orientation);
+}
+
 void SeatTouch::onDown(uint32_t serial, uint32_t time, wl_surface* surface,
 					   int32_t id, wl_fixed_t x, wl_fixed_t y)
 {
@@ -100,6 +113,8 @@ void SeatTouch::onDown(uint32_t serial, uint32_t time, wl_surface* surface,
 	if (mCurrentCallback != mSurfaceCallbacks.end() &&
 		mCurrentCallback->second.down)
 	{
+		startFrame(time);
+
 		mCurrentCallback->second.down(id, resX, resY);
 	}
 	else
@@ -120,12 +135,9 @@ void SeatTouch::onUp(uint32_t serial, uint32_t time, int32_t id)
 	if (mCurrentCallback != mSurfaceCallbacks.end() &&
 		mCurrentCallback->second.up)
 	{
-		mCurrentCallback->second.up(id);
+		startFrame(time);
 
-		if (mCurrentCallback->second.frame)
-		{
-			mCurrentCallback->second.frame(mCurrentId);
-		}
+		mCurrentCallback->second.up(id);
 	}
 	else
 	{
@@ -148,6 +160,8 @@ void SeatTouch::onMotion(uint32_t time, int32_t id, wl_fixed_t x, wl_fixed_t y)
 	if (mCurrentCallback != mSurfaceCallbacks.end() &&
 		mCurrentCallback->second.motion)
 	{
+		startFrame(time);
+
 		mCurrentCallback->second.motion(id, resX, resY);
 	}
 	else
@@ -166,6 +180,8 @@ void SeatTouch::onFrame()
 		mCurrentCallback->second.frame)
 	{
 		mCurrentCallback->second.frame(mCurrentId);
+
+		measureLatency();
 	}
 }
 
@@ -176,6 +192,42 @@ void SeatTouch::onCancel()
 	DLOG(mLog, DEBUG) << "onCancel";
 }
 
+void SeatTouch::onShape(int32_t id, wl_fixed_t major, wl_fixed_t minor)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	uint32_t resMajor = wl_fixed_to_int(major);
+	uint32_t resMinor = wl_fixed_to_int(minor);
+
+	DLOG(mLog, DEBUG) << "onShape id: " << id << ", major: " << resMajor
+					  << ", minor: " << resMinor;
+
+	// shape and orientation come in the frame of the contact down or motion
+	// which has already started the frame
+
+	if (mCurrentCallback != mSurfaceCallbacks.end() &&
+		mCurrentCallback->second.shape)
+	{
+		mCurrentCallback->second.shape(id, resMajor, resMinor);
+	}
+}
+
+void SeatTouch::onOrientation(int32_t id, wl_fixed_t orientation)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	int32_t resOrientation = wl_fixed_to_int(orientation);
+
+	DLOG(mLog, DEBUG) << "onOrientation id: " << id
+					  << ", orientation: " << resOrientation;
+
+	if (mCurrentCallback != mSurfaceCallbacks.end() &&
+		mCurrentCallback->second.orientation)
+	{
+		mCurrentCallback->second.orientation(id, resOrientation);
+	}
+}
+
 void SeatTouch::init(wl_seat* seat)
 {
 	mWlTouch = wl_seat_get_touch(seat);
@@ -185,7 +237,8 @@ void SeatTouch::init(wl_seat* seat)
 		throw Exception("Can't create pointer", errno);
 	}
 
-	mListener = { sOnDown, sOnUp, sOnMotion, sOnFrame, sOnCancel };
+	mListener = { sOnDown, sOnUp, sOnMotion, sOnFrame, sOnCancel,
+				  sOnShape, sOnOrientation };
 
 	if (wl_touch_add_listener(mWlTouch, &mListener, this))
 	{
@@ -43,6 +43,10 @@ private:
 						  int32_t id, wl_fixed_t x, wl_fixed_t y);
 	static void sOnFrame(void* data, wl_touch* touch);
 	static void sOnCancel(void* data, wl_touch* touch);
+	static void sOnShape(void* data, wl_touch* touch, int32_t id,
+						 wl_fixed_t major, wl_fixed_t minor);
+	static void sOnOrientation(void* data, wl_touch* touch, int32_t id,
+							   wl_fixed_t orientation);
 
 	void onDown(uint32_t serial, uint32_t time, wl_surface* surface,
 				int32_t id, wl_fixed_t x, wl_fixed_t y);
@@ -50,6 +54,8 @@ private:
 	void onMotion(uint32_t time, int32_t id, wl_fixed_t x, wl_fixed_t y);
 	void onFrame();
 	void onCancel();
+	void onShape(int32_t id, wl_fixed_t major, wl_fixed_t minor);
+	void onOrientation(int32_t id, wl_fixed_t orientation);
 
 	void init(wl_seat* seat);
 	void release();
@@ -7,18 +7,14 @@
 
 #include "SharedFile.hpp"
 
-#include <cstdlib>
-#include <string>
+#include <cstring>
 
-#include <fcntl.h>
 #include <sys/mman.h>
-#include <unistd.h>
 
 #include "Exception.hpp"
 
-using std::string;
-
-using XenBackend::XenGnttabBuffer;
+using std::lock_guard;
+using std::mutex;
 
 namespace Wayland {
 
@@ -26,13 +22,20 @@ namespace Wayland {
  * SharedFile
  ******************************************************************************/
 
-SharedFile::SharedFile(uint32_t width, uint32_t height, uint32_t bpp,
+SharedFile::SharedFile(SharedPoolPtr pool, size_t poolOffset,
+					   uint32_t width, uint32_t height, uint32_t stride,
 					   size_t offset, domid_t domId, const GrantRefs& refs) :
-	mFd(-1),
-	mBuffer(nullptr),
+	mPool(pool),
+	mPoolOffset(poolOffset),
+	mShadowOffset(0),
+	mHasShadow(false),
+	mCurrentRange(PRIMARY_RANGE),
+	mAttachedRange(PRIMARY_RANGE),
+	mBusy{false, false},
+	mBusyCollisions(0),
 	mWidth(width),
 	mHeight(height),
-	mStride(4 * ((width * bpp + 31) / 32)),
+	mStride(stride),
 	mSize(height * mStride),
 	mLog("SharedFile")
 {
@@ -64,9 +67,39 @@ void SharedFile::copy()
 		throw Exception("There is no buffer to copy from", ENOENT);
 	}
 
-	DLOG("Dumb", DEBUG) << "Copy dumb, handle: " << mFd;
+	lock_guard<mutex> lock(mMutex);
+
+	if (mBusy[mCurrentRange])
+	{
+		// don't overwrite the range the compositor may read from
+
+		if (!mHasShadow)
+		{
+			allocateShadow();
+		}
+
+		int other = mCurrentRange == PRIMARY_RANGE ?
+					SHADOW_RANGE : PRIMARY_RANGE;
+
+		if (mHasShadow && !mBusy[other])
+		{
+			mCurrentRange = other;
+		}
+		else
+		{
+			mBusyCollisions++;
+
+			DLOG(mLog, WARNING) << "Copy to busy buffer, collisions: "
+								<< mBusyCollisions;
+		}
+	}
+
+	DLOG("Dumb", DEBUG) << "Copy dumb, offset: "
+						<< getRangeOffset(mCurrentRange);
+
+	lock_guard<LazyGnttabBuffer> bufferLock(*mGnttabBuffer);
 
-	memcpy(mBuffer, mGnttabBuffer->get(), mSize);
+	memcpy(getBuffer(), mGnttabBuffer->get(), mSize);
 }
 
 /*******************************************************************************
@@ -75,76 +108,70 @@ void SharedFile::copy()
 
 void SharedFile::init(domid_t domId, size_t offset, const GrantRefs& refs)
 {
-	createTmpFile();
-
 	LOG(mLog, DEBUG) << "Create, w: " << mWidth << ", h: " << mHeight
-					 << ", stride: " << mStride << ", fd: " << mFd
+					 << ", stride: " << mStride << ", fd: " << mPool->getFd()
+					 << ", pool offset: " << mPoolOffset
 					 << ", offset: " << offset;
 
-	auto map = mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
-
-	if (map == MAP_FAILED)
-	{
-		throw Exception("Can't map shared file", errno);
-	}
-
-	mBuffer = map;
+	// the grant buffer is mapped on first copy
 
 	if (refs.size())
 	{
-		mGnttabBuffer.reset(
-				new XenGnttabBuffer(domId, refs.data(), refs.size(),
-									PROT_READ | PROT_WRITE,
-									offset));
+		mGnttabBuffer.reset(new LazyGnttabBuffer(domId, refs, offset));
 	}
 }
 
-void SharedFile::release()
+int SharedFile::attachCurrentRange()
 {
-	if (mFd >= 0)
-	{
-		close(mFd);
-	}
+	lock_guard<mutex> lock(mMutex);
 
-	if (mBuffer)
-	{
-		munmap(mBuffer, mSize);
+	mAttachedRange = mCurrentRange;
+	mBusy[mAttachedRange] = true;
 
-		LOG(mLog, DEBUG) << "Delete, fd: " << mFd;
-	}
+	return mAttachedRange;
 }
 
-void SharedFile::createTmpFile()
+int SharedFile::getAttachedRange()
 {
-	string templateName(getenv(cXdgRuntimeVar));
-
-	if (templateName.empty())
-	{
-		throw Exception("Can't get XDG_RUNTIME_DIR environment var", EINVAL);
-	}
+	lock_guard<mutex> lock(mMutex);
 
-	templateName += string(cFileNameTemplate);
+	return mAttachedRange;
+}
 
-	char name[templateName.length() + 1];
+bool SharedFile::releaseRange(int range)
+{
+	lock_guard<mutex> lock(mMutex);
 
-	strcpy(name, templateName.c_str());
+	mBusy[range] = false;
 
-	mFd = mkostemp(name, O_CLOEXEC);
+	return mAttachedRange == range;
+}
 
-	if (mFd < 0)
+void SharedFile::allocateShadow()
+{
+	if (!mPool->allocate(mSize, mShadowOffset))
 	{
-		throw Exception("Can't create file: " + string(name), errno);
+		DLOG(mLog, WARNING) << "Can't allocate shadow buffer";
+
+		return;
 	}
 
-	unlink(name);
+	mHasShadow = true;
+
+	LOG(mLog, DEBUG) << "Allocate shadow, pool offset: " << mShadowOffset;
+}
 
-	if (ftruncate(mFd, mSize) < 0)
+void SharedFile::release()
+{
+	mPool->free(mPoolOffset, mSize);
+
+	if (mHasShadow)
 	{
-		throw Exception("Can't truncate file: " + string(name), errno);
+		mPool->free(mShadowOffset, mSize);
 	}
 
-	LOG(mLog, DEBUG) << "Create tmp file: " << name;
+	LOG(mLog, DEBUG) << "Delete, pool offset: " << mPoolOffset
+					 << ", busy collisions: " << mBusyCollisions;
 }
 
 }
-
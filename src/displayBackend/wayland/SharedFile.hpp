@@ -22,15 +22,21 @@
 #ifndef SRC_WAYLAND_SHAREDFILE_HPP_
 #define SRC_WAYLAND_SHAREDFILE_HPP_
 
+#include <mutex>
+
 #include <xen/be/Log.hpp>
 #include <xen/be/XenGnttab.hpp>
 
 #include "DisplayItf.hpp"
+#include "LazyGnttabBuffer.hpp"
+#include "SharedPool.hpp"
 
 namespace Wayland {
 
 /***************************************************************************//**
  * Shared file class.
+ * If the compositor still holds the range being copied to, the copy goes to
+ * a shadow range of the pool which is allocated on the first such collision.
  * @ingroup wayland
  ******************************************************************************/
 class SharedFile : public DisplayItf::DisplayBuffer
@@ -42,7 +48,10 @@ public:
 	/**
 	 * Returns pointer to the beginning of buffer
 	 */
-	void* getBuffer() const override { return mBuffer; }
+	void* getBuffer() const override
+	{
+		return mPool->getBuffer(getRangeOffset(mCurrentRange));
+	}
 
 	/**
 	 * Returns buffer size
@@ -62,7 +71,7 @@ public:
 	/**
 	 * Gets fd
 	 */
-	int getFd() const override { return mFd; };
+	int getFd() const override { return mPool->getFd(); };
 
 	/**
 	 * Indicates if copy operation shall be applied
@@ -84,15 +93,25 @@ private:
 	friend class SharedMemory;
 	friend class SharedBuffer;
 
-	SharedFile(
-			uint32_t width, uint32_t height, uint32_t bpp, size_t offset,
-			domid_t domId, const GrantRefs& refs);
-
-	constexpr static const char *cFileNameTemplate = "/weston-shared-XXXXXX";
-	constexpr static const char *cXdgRuntimeVar = "XDG_RUNTIME_DIR";
-
-	int mFd;
-	void* mBuffer;
+	SharedFile(SharedPoolPtr pool, size_t poolOffset,
+			   uint32_t width, uint32_t height, uint32_t stride, size_t offset,
+			   domid_t domId, const GrantRefs& refs);
+
+	enum Range
+	{
+		PRIMARY_RANGE,
+		SHADOW_RANGE,
+		NUM_RANGES
+	};
+
+	SharedPoolPtr mPool;
+	size_t mPoolOffset;
+	size_t mShadowOffset;
+	bool mHasShadow;
+	int mCurrentRange;
+	int mAttachedRange;
+	bool mBusy[NUM_RANGES];
+	uint64_t mBusyCollisions;
 	uint32_t mWidth;
 	uint32_t mHeight;
 	uint32_t mStride;
@@ -100,11 +119,22 @@ private:
 
 	XenBackend::Log mLog;
 
-	std::unique_ptr<XenBackend::XenGnttabBuffer> mGnttabBuffer;
+	std::unique_ptr<LazyGnttabBuffer> mGnttabBuffer;
+
+	std::mutex mMutex;
+
+	size_t getRangeOffset(int range) const
+	{
+		return range == SHADOW_RANGE ? mShadowOffset : mPoolOffset;
+	}
+
+	int attachCurrentRange();
+	int getAttachedRange();
+	bool releaseRange(int range);
+	void allocateShadow();
 
 	void init(domid_t domId, size_t offset, const GrantRefs& refs);
 	void release();
-	void createTmpFile();
 };
 
 typedef std::shared_ptr<SharedFile> SharedFilePtr;
@@ -11,8 +11,10 @@
 
 #include "Exception.hpp"
 
+using std::dynamic_pointer_cast;
 using std::find;
 using std::hex;
+using std::max;
 using std::setfill;
 using std::setw;
 
@@ -63,7 +65,33 @@ SharedFilePtr SharedMemory::createSharedFile(
 {
 	LOG(mLog, DEBUG) << "Create shared file";
 
-	return SharedFilePtr(new SharedFile(width, height, bpp, offset,
+	uint32_t stride = 4 * ((width * bpp + 31) / 32);
+	size_t size = height * stride;
+	size_t poolOffset = 0;
+
+	for (auto pool : mPools)
+	{
+		if (pool->allocate(size, poolOffset))
+		{
+			return SharedFilePtr(new SharedFile(pool, poolOffset,
+												width, height, stride, offset,
+												domId, refs));
+		}
+	}
+
+	SharedPoolPtr pool(new SharedPool(mWlSharedMemory,
+									  max(size, cPoolSize),
+									  max(size, cPoolMaxSize)));
+
+	mPools.push_back(pool);
+
+	if (!pool->allocate(size, poolOffset))
+	{
+		throw Exception("Can't allocate shared file", ENOMEM);
+	}
+
+	return SharedFilePtr(new SharedFile(pool, poolOffset,
+										width, height, stride, offset,
 										domId, refs));
 }
 
@@ -80,9 +108,14 @@ SharedBufferPtr SharedMemory::createSharedBuffer(
 		throw Exception("Unsupported pixel format", EINVAL);
 	}
 
-	return SharedBufferPtr(new SharedBuffer(mWlSharedMemory,
-											displayBuffer,
-											width, height,
+	auto sharedFile = dynamic_pointer_cast<SharedFile>(displayBuffer);
+
+	if (!sharedFile)
+	{
+		throw Exception("Display buffer is not a shared file", EINVAL);
+	}
+
+	return SharedBufferPtr(new SharedBuffer(sharedFile, width, height,
 											format));
 }
 
@@ -124,6 +157,8 @@ void SharedMemory::init()
 
 void SharedMemory::release()
 {
+	mPools.clear();
+
 	if (mWlSharedMemory)
 	{
 		wl_shm_destroy(mWlSharedMemory);
@@ -16,6 +16,7 @@
 #include "FrameBuffer.hpp"
 #include "Registry.hpp"
 #include "SharedFile.hpp"
+#include "SharedPool.hpp"
 
 namespace Wayland {
 
@@ -30,7 +31,7 @@ public:
 	~SharedMemory();
 
 	/**
-	 * Creates shared file
+	 * Creates shared file, the file is allocated in one of the shared pools
 	 * @param width  width
 	 * @param height height
 	 * @param bpp    bits per pixel
@@ -60,6 +61,9 @@ private:
 
 	SharedMemory(wl_registry* registry, uint32_t id, uint32_t version);
 
+	const size_t cPoolSize = 32 * 1024 * 1024;
+	const size_t cPoolMaxSize = 256 * 1024 * 1024;
+
 	wl_shm* mWlSharedMemory;
 	XenBackend::Log mLog;
 
@@ -67,6 +71,8 @@ private:
 
 	std::list<uint32_t> mSupportedFormats;
 
+	std::list<SharedPoolPtr> mPools;
+
 	static void sFormatHandler(void *data, wl_shm *wlShm, uint32_t format);
 
 	void formatHandler(uint32_t format);
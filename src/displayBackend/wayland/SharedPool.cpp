@@ -0,0 +1,502 @@
+/*
+ *  Wayland shared memory pool
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "SharedPool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Exception.hpp"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC              0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING        0x0002U
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB              0x0004U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS              (1024 + 9)
+#endif
+#ifndef F_SEAL_SHRINK
+#define F_SEAL_SHRINK            0x0002
+#endif
+#ifndef FALLOC_FL_KEEP_SIZE
+#define FALLOC_FL_KEEP_SIZE      0x01
+#endif
+#ifndef FALLOC_FL_PUNCH_HOLE
+#define FALLOC_FL_PUNCH_HOLE     0x02
+#endif
+
+using std::lock_guard;
+using std::max;
+using std::min;
+using std::mutex;
+using std::prev;
+using std::string;
+
+namespace Wayland {
+
+/*******************************************************************************
+ * SharedPool
+ ******************************************************************************/
+
+SharedPool::SharedPool(wl_shm* wlSharedMemory, size_t size, size_t maxSize) :
+	mFd(-1),
+	mReserved(nullptr),
+	mReservedSize(0),
+	mBuffer(nullptr),
+	mSize(0),
+	mUsedSize(0),
+	mMaxSize(maxSize),
+	mGranularity(sysconf(_SC_PAGESIZE)),
+	mHugeTlb(false),
+	mPunchHoles(true),
+	mWlPool(nullptr),
+	mLog("SharedPool")
+{
+	try
+	{
+		init(wlSharedMemory, size);
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+SharedPool::~SharedPool()
+{
+	release();
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+bool SharedPool::allocate(size_t size, size_t& offset)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	size = align(size);
+
+	if (takeFreeRange(size, offset))
+	{
+		clearRange(offset, size);
+
+		return true;
+	}
+
+	// free range at the end of the pool is extended by growing
+
+	size_t tailSize = 0;
+
+	if (!mFreeRanges.empty())
+	{
+		auto last = prev(mFreeRanges.end());
+
+		if (last->first + last->second == mSize)
+		{
+			tailSize = last->second;
+		}
+	}
+
+	size_t newSize = mSize - tailSize + size;
+
+	if (newSize > mMaxSize)
+	{
+		return false;
+	}
+
+	if (!grow(max(newSize, min(2 * mSize, mMaxSize))) ||
+		!takeFreeRange(size, offset))
+	{
+		return false;
+	}
+
+	clearRange(offset, size);
+
+	return true;
+}
+
+void SharedPool::free(size_t offset, size_t size)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	size = align(size);
+
+	punchRange(offset, size);
+	insertFreeRange(offset, size);
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void SharedPool::init(wl_shm* wlSharedMemory, size_t size)
+{
+	createFile();
+
+	mMaxSize = alignHuge(mMaxSize);
+	size = min(alignHuge(size), mMaxSize);
+
+	// Reserve the whole range, the file is mapped over it while growing.
+	// One more huge page is reserved to align the range.
+
+	auto map = mmap(NULL, mMaxSize + cHugePageSize, PROT_NONE,
+					MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (map == MAP_FAILED)
+	{
+		throw Exception("Can't reserve shared pool", errno);
+	}
+
+	mReserved = map;
+	mReservedSize = mMaxSize + cHugePageSize;
+
+	mBuffer = reinterpret_cast<void*>(
+			alignHuge(reinterpret_cast<uintptr_t>(mReserved)));
+
+	if (!mapFile(0, size))
+	{
+		if (!mHugeTlb)
+		{
+			throw Exception("Can't map shared pool", errno);
+		}
+
+		LOG(mLog, WARNING) << "Can't map hugetlb memfd, err: " << errno
+						   << ", fallback to memfd";
+
+		close(mFd);
+
+		mFd = -1;
+		mHugeTlb = false;
+		mGranularity = sysconf(_SC_PAGESIZE);
+
+		createPlainFile();
+
+		if (!mapFile(0, size))
+		{
+			throw Exception("Can't map shared pool", errno);
+		}
+	}
+
+	mWlPool = wl_shm_create_pool(wlSharedMemory, mFd, size);
+
+	if (!mWlPool)
+	{
+		throw Exception("Can't create pool", errno);
+	}
+
+	mSize = size;
+
+	insertFreeRange(0, mSize);
+
+	LOG(mLog, DEBUG) << "Create, fd: " << mFd << ", size: " << mSize
+					 << ", max size: " << mMaxSize;
+}
+
+void SharedPool::release()
+{
+	if (mWlPool)
+	{
+		wl_shm_pool_destroy(mWlPool);
+	}
+
+	if (mReserved)
+	{
+		munmap(mReserved, mReservedSize);
+	}
+
+	if (mFd >= 0)
+	{
+		close(mFd);
+
+		LOG(mLog, DEBUG) << "Delete, fd: " << mFd;
+	}
+}
+
+void SharedPool::createFile()
+{
+#ifdef WITH_HUGETLB
+	if (createMemFd(MFD_HUGETLB))
+	{
+		mGranularity = cHugePageSize;
+		mHugeTlb = true;
+
+		return;
+	}
+
+	LOG(mLog, WARNING) << "Can't create hugetlb memfd, err: " << errno;
+#endif
+
+	createPlainFile();
+}
+
+void SharedPool::createPlainFile()
+{
+	if (createMemFd(0))
+	{
+		return;
+	}
+
+	LOG(mLog, WARNING) << "Can't create memfd, err: " << errno
+					   << ", fallback to tmp file";
+
+	createTmpFile();
+}
+
+bool SharedPool::createMemFd(unsigned int flags)
+{
+#ifdef SYS_memfd_create
+	mFd = syscall(SYS_memfd_create, cMemFdName,
+				  MFD_CLOEXEC | MFD_ALLOW_SEALING | flags);
+#else
+	mFd = -1;
+	errno = ENOSYS;
+#endif
+
+	if (mFd < 0)
+	{
+		return false;
+	}
+
+	// The pool only grows: protect the compositor mapping from being
+	// truncated under it.
+
+	if (fcntl(mFd, F_ADD_SEALS, F_SEAL_SHRINK) < 0)
+	{
+		LOG(mLog, WARNING) << "Can't seal memfd, err: " << errno;
+	}
+
+	LOG(mLog, DEBUG) << "Create memfd: " << mFd << ", flags: " << flags;
+
+	return true;
+}
+
+void SharedPool::createTmpFile()
+{
+	auto runtimeDir = getenv(cXdgRuntimeVar);
+
+	if (!runtimeDir)
+	{
+		throw Exception("Can't get XDG_RUNTIME_DIR environment var", EINVAL);
+	}
+
+	string templateName = string(runtimeDir) + string(cFileNameTemplate);
+
+	char name[templateName.length() + 1];
+
+	strcpy(name, templateName.c_str());
+
+	mFd = mkostemp(name, O_CLOEXEC);
+
+	if (mFd < 0)
+	{
+		throw Exception("Can't create file: " + string(name), errno);
+	}
+
+	unlink(name);
+
+	LOG(mLog, DEBUG) << "Create tmp file: " << name;
+}
+
+size_t SharedPool::align(size_t size) const
+{
+	return (size + mGranularity - 1) / mGranularity * mGranularity;
+}
+
+size_t SharedPool::alignHuge(size_t size) const
+{
+	return (size + cHugePageSize - 1) / cHugePageSize * cHugePageSize;
+}
+
+bool SharedPool::mapFile(size_t offset, size_t size)
+{
+	// hugetlb memfd without reserved pages fails here rather than on create
+
+	if (ftruncate(mFd, offset + size) < 0)
+	{
+		return false;
+	}
+
+	if (mmap(getBuffer(offset), size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_FIXED, mFd, offset) == MAP_FAILED)
+	{
+		auto err = errno;
+
+		// failed fixed mapping may leave a hole in the reserved range
+
+		mmap(getBuffer(offset), size, PROT_NONE,
+			 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+
+		errno = err;
+
+		return false;
+	}
+
+	if (!mHugeTlb)
+	{
+		// Ask for transparent huge pages, it reduces TLB misses on copy.
+		// It is only a hint: shmem THP may be disabled in the system.
+
+		madvise(getBuffer(offset), size, MADV_HUGEPAGE);
+	}
+
+	return true;
+}
+
+bool SharedPool::grow(size_t size)
+{
+	size = min(alignHuge(size), mMaxSize);
+
+	if (size <= mSize)
+	{
+		return true;
+	}
+
+	if (!mapFile(mSize, size - mSize))
+	{
+		LOG(mLog, WARNING) << "Can't grow shared pool, fd: " << mFd
+						   << ", size: " << size << ", err: " << errno;
+
+		// don't try again, next allocations go to another pool
+
+		mMaxSize = mSize;
+
+		return false;
+	}
+
+	wl_shm_pool_resize(mWlPool, size);
+
+	LOG(mLog, DEBUG) << "Grow, fd: " << mFd << ", size: " << size;
+
+	insertFreeRange(mSize, size - mSize);
+
+	mSize = size;
+
+	return true;
+}
+
+bool SharedPool::takeFreeRange(size_t size, size_t& offset)
+{
+	for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); it++)
+	{
+		if (it->second >= size)
+		{
+			offset = it->first;
+
+			auto rest = it->second - size;
+
+			mFreeRanges.erase(it);
+
+			if (rest)
+			{
+				mFreeRanges[offset + size] = rest;
+			}
+
+			DLOG(mLog, DEBUG) << "Allocate, offset: " << offset
+							  << ", size: " << size;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SharedPool::punchRange(size_t offset, size_t size)
+{
+	// give the pages of the freed range back to the system, the range
+	// reads as zeros afterwards
+
+	if (!mPunchHoles)
+	{
+		return;
+	}
+
+	if (fallocate(mFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+				  offset, size) < 0)
+	{
+		LOG(mLog, WARNING) << "Can't punch hole, fd: " << mFd
+						   << ", offset: " << offset << ", size: " << size
+						   << ", err: " << errno;
+
+		// from now freed ranges keep their data and are zeroed on allocation
+
+		mPunchHoles = false;
+	}
+}
+
+void SharedPool::clearRange(size_t offset, size_t size)
+{
+	// the range may be shown before the first copy into it, it shall not
+	// keep a frame of the previous owner which may be another domain
+
+	if (!mPunchHoles && offset < mUsedSize)
+	{
+		memset(getBuffer(offset), 0, min(offset + size, mUsedSize) - offset);
+	}
+
+	mUsedSize = max(mUsedSize, offset + size);
+}
+
+void SharedPool::insertFreeRange(size_t offset, size_t size)
+{
+	auto it = mFreeRanges.emplace(offset, size).first;
+
+	// merge with the next range
+
+	auto next = it;
+
+	if (++next != mFreeRanges.end() && it->first + it->second == next->first)
+	{
+		it->second += next->second;
+
+		mFreeRanges.erase(next);
+	}
+
+	// merge with the previous range
+
+	if (it != mFreeRanges.begin())
+	{
+		auto prevIt = prev(it);
+
+		if (prevIt->first + prevIt->second == it->first)
+		{
+			prevIt->second += it->second;
+
+			mFreeRanges.erase(it);
+		}
+	}
+}
+
+}
@@ -0,0 +1,143 @@
+/*
+ *  Wayland shared memory pool
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_WAYLAND_SHAREDPOOL_HPP_
+#define SRC_WAYLAND_SHAREDPOOL_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <wayland-client.h>
+
+#include <xen/be/Log.hpp>
+
+namespace Wayland {
+
+/***************************************************************************//**
+ * Wayland shared memory pool class.
+ * Wraps one file, one mapping and one wl_shm_pool which are sub-allocated
+ * for shared files. The pool grows on demand up to its maximum size: the
+ * whole virtual range is reserved at creation, so growing never moves
+ * buffers which are already allocated. Freed ranges are punched out of the
+ * file, so their pages go back to the system and a buffer never shows data
+ * of its previous owner. If the file doesn't support punching holes, ranges
+ * which were used before are zeroed on allocation instead.
+ * The file is a sealed memfd (hugetlb backed if built with WITH_HUGETLB),
+ * or a tmp file in XDG_RUNTIME_DIR if memfd is not available. If hugetlb
+ * pages can't be mapped, e.g. none are reserved, the pool falls back to a
+ * plain memfd. The mapping is 2 MiB aligned and grows by 2 MiB steps in both
+ * cases, so a plain memfd can be backed by transparent huge pages.
+ * @ingroup wayland
+ ******************************************************************************/
+class SharedPool
+{
+public:
+
+	~SharedPool();
+
+	/**
+	 * Allocates a range of the pool, grows the pool if required
+	 * @param size   range size
+	 * @param offset allocated range offset
+	 * @return false if the pool can't fit the range
+	 */
+	bool allocate(size_t size, size_t& offset);
+
+	/**
+	 * Returns the range to the pool
+	 * @param offset range offset
+	 * @param size   range size
+	 */
+	void free(size_t offset, size_t size);
+
+	/**
+	 * Returns pointer to the range data
+	 * @param offset range offset
+	 */
+	void* getBuffer(size_t offset) const
+	{
+		return static_cast<uint8_t*>(mBuffer) + offset;
+	}
+
+	/**
+	 * Returns wayland pool
+	 */
+	wl_shm_pool* getWlPool() const { return mWlPool; }
+
+	/**
+	 * Gets fd
+	 */
+	int getFd() const { return mFd; }
+
+private:
+
+	friend class SharedMemory;
+
+	SharedPool(wl_shm* wlSharedMemory, size_t size, size_t maxSize);
+
+	constexpr static const char *cMemFdName = "weston-shared";
+	constexpr static const char *cFileNameTemplate = "/weston-shared-XXXXXX";
+	constexpr static const char *cXdgRuntimeVar = "XDG_RUNTIME_DIR";
+	const size_t cHugePageSize = 2 * 1024 * 1024;
+
+	int mFd;
+	void* mReserved;
+	size_t mReservedSize;
+	void* mBuffer;
+	size_t mSize;
+	// ranges above it were never allocated and are still zero
+	size_t mUsedSize;
+	size_t mMaxSize;
+	size_t mGranularity;
+	bool mHugeTlb;
+	// all freed ranges were punched out and are zero
+	bool mPunchHoles;
+	wl_shm_pool* mWlPool;
+
+	XenBackend::Log mLog;
+
+	std::mutex mMutex;
+
+	// offset -> size of free ranges
+	std::map<size_t, size_t> mFreeRanges;
+
+	void init(wl_shm* wlSharedMemory, size_t size);
+	void release();
+	void createFile();
+	void createPlainFile();
+	bool createMemFd(unsigned int flags);
+	void createTmpFile();
+	size_t align(size_t size) const;
+	size_t alignHuge(size_t size) const;
+	bool mapFile(size_t offset, size_t size);
+	bool grow(size_t size);
+	bool takeFreeRange(size_t size, size_t& offset);
+	void punchRange(size_t offset, size_t size);
+	void clearRange(size_t offset, size_t size);
+	void insertFreeRange(size_t offset, size_t size);
+};
+
+typedef std::shared_ptr<SharedPool> SharedPoolPtr;
+
+}
+
+#endif /* SRC_WAYLAND_SHAREDPOOL_HPP_ */
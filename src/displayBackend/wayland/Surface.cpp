@@ -7,10 +7,13 @@
 
 #include "Surface.hpp"
 
+#include <cstdint>
+
 #include "Exception.hpp"
 #include "FrameBuffer.hpp"
 
 using std::chrono::milliseconds;
+using std::lock_guard;
 using std::mutex;
 using std::thread;
 using std::unique_lock;
@@ -87,8 +90,10 @@ void Surface::draw(FrameBufferPtr frameBuffer,
 		mBuffer->setSurface(this);
 	}
 
-	wl_surface_damage(mWlSurface, 0, 0,
-					  frameBuffer->getWidth(), frameBuffer->getHeight());
+	// damage is in surface coordinates which differ from the buffer ones
+	// when the surface is scaled by viewport
+
+	wl_surface_damage(mWlSurface, 0, 0, INT32_MAX, INT32_MAX);
 
 	wl_surface_attach(mWlSurface,
 					  reinterpret_cast<wl_buffer*>(frameBuffer->getHandle()),
@@ -112,6 +117,42 @@ void Surface::clear()
 	wl_surface_commit(mWlSurface);
 }
 
+bool Surface::isActive()
+{
+	unique_lock<mutex> lock(mMutex);
+
+	return !mWaitForFrame;
+}
+
+void Surface::setActiveCallback(FrameCallback callback)
+{
+	lock_guard<mutex> lock(mActiveMutex);
+
+	mActiveCallback = callback;
+}
+
+void Surface::redraw()
+{
+	unique_lock<mutex> lock(mMutex);
+
+	if (!mBuffer)
+	{
+		return;
+	}
+
+	DLOG(mLog, DEBUG) << "Redraw";
+
+	mBuffer->setSurface(this);
+
+	wl_surface_damage(mWlSurface, 0, 0, INT32_MAX, INT32_MAX);
+
+	wl_surface_attach(mWlSurface,
+					  reinterpret_cast<wl_buffer*>(mBuffer->getHandle()),
+					  0, 0);
+
+	wl_surface_commit(mWlSurface);
+}
+
 /*******************************************************************************
  * Private
  ******************************************************************************/
@@ -133,15 +174,26 @@ void Surface::frameHandler()
 
 	sendCallback();
 
-	if (mWaitForFrame)
+	if (!mWaitForFrame)
 	{
-		mWaitForFrame = false;
+		mCondVar.notify_one();
 
-		LOG(mLog, DEBUG) << "Surface is active";
+		return;
 	}
-	else
+
+	mWaitForFrame = false;
+
+	LOG(mLog, DEBUG) << "Surface is active";
+
+	// the callback draws, it is called without the surface lock
+
+	lock.unlock();
+
+	lock_guard<mutex> activeLock(mActiveMutex);
+
+	if (mActiveCallback)
 	{
-		mCondVar.notify_one();
+		mActiveCallback();
 	}
 }
 
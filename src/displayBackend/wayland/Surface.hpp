@@ -50,6 +50,24 @@ public:
 	 */
 	void clear();
 
+	/**
+	 * Checks if the compositor displays the surface i.e. frame callbacks
+	 * are received in time
+	 */
+	bool isActive();
+
+	/**
+	 * Sets callback which is called when the surface becomes active again.
+	 * When it returns, the previous callback is not called anymore.
+	 * @param callback callback, nullptr to reset
+	 */
+	void setActiveCallback(FrameCallback callback);
+
+	/**
+	 * Commits the current buffer again, e.g. after its content is updated
+	 */
+	void redraw();
+
 private:
 
 	friend class Display;
@@ -58,6 +76,7 @@ private:
 	friend class ShellSurface;
 	friend class Compositor;
 	friend class Connector;
+	friend class Viewport;
 
 	const uint32_t cFrameTimeoutMs = 50;
 
@@ -78,6 +97,9 @@ private:
 
 	FrameCallback mStoredCallback;
 
+	std::mutex mActiveMutex;
+	FrameCallback mActiveCallback;
+
 	static void sFrameHandler(void *data, wl_callback *wl_callback,
 							  uint32_t callback_data);
 	void frameHandler();
@@ -23,11 +23,12 @@
 
 #include "Exception.hpp"
 
+using std::atomic_load;
+using std::atomic_store;
 using std::find;
-using std::find_if;
 using std::lock_guard;
+using std::make_shared;
 using std::mutex;
-using std::pair;
 using std::string;
 
 namespace Wayland {
@@ -37,6 +38,7 @@ namespace Wayland {
  ******************************************************************************/
 
 SurfaceManager::SurfaceManager() :
+	mIndex(make_shared<Index>()),
 	mLog("SurfaceManager")
 {
 
@@ -56,7 +58,19 @@ void SurfaceManager::createSurface(const string& connectorName,
 
 	LOG(mLog, DEBUG) << "Create surface: " << connectorName;
 
-	mSurfaces[connectorName] = surface;
+	auto index = make_shared<Index>(*mIndex);
+
+	auto it = index->surfaces.find(connectorName);
+
+	if (it != index->surfaces.end())
+	{
+		index->connectors.erase(it->second);
+	}
+
+	index->surfaces[connectorName] = surface;
+	index->connectors[surface] = connectorName;
+
+	atomic_store(&mIndex, IndexPtr(index));
 
 	for(auto subscriber : mSubscribers)
 	{
@@ -76,16 +90,21 @@ void SurfaceManager::deleteSurface(const string& connectorName,
 		subscriber->onSurfaceDelete(connectorName, surface);
 	}
 
-	mSurfaces.erase(connectorName);
+	auto index = make_shared<Index>(*mIndex);
+
+	index->surfaces.erase(connectorName);
+	index->connectors.erase(surface);
+
+	atomic_store(&mIndex, IndexPtr(index));
 }
 
 wl_surface* SurfaceManager::getSurfaceByConnectorName(const string& connectorName)
 {
-	lock_guard<mutex> lock(mMutex);
+	auto index = atomic_load(&mIndex);
 
-	auto it = mSurfaces.find(connectorName);
+	auto it = index->surfaces.find(connectorName);
 
-	if (it != mSurfaces.end())
+	if (it != index->surfaces.end())
 	{
 		return it->second;
 	}
@@ -95,20 +114,16 @@ wl_surface* SurfaceManager::getSurfaceByConnectorName(const string& connectorNam
 
 string SurfaceManager::getConnectorNameBySurface(wl_surface* surface)
 {
-	lock_guard<mutex> lock(mMutex);
-
-	string result;
+	auto index = atomic_load(&mIndex);
 
-	auto it = find_if(mSurfaces.begin(), mSurfaces.end(),
-					  [&surface](const pair<string, wl_surface*>& value)
-					  { return value.second == surface; });
+	auto it = index->connectors.find(surface);
 
-	if (it != mSurfaces.end())
+	if (it != index->connectors.end())
 	{
-		result = it->first;
+		return it->second;
 	}
 
-	return result;
+	return string();
 }
 
 void SurfaceManager::subscribe(SurfaceNotificationItf* subscriber)
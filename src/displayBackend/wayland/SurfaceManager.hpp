@@ -23,6 +23,7 @@
 #define SRC_WAYLAND_SURFACEMANAGER_HPP_
 
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -41,6 +42,13 @@ public:
 								 wl_surface* surface) = 0;
 };
 
+/***************************************************************************//**
+ * Maps connector names to surfaces and back.
+ * Lookups are done on an immutable snapshot of the index, so seat event
+ * handling doesn't contend with surface creation: create and delete build
+ * a new snapshot under the mutex and publish it atomically.
+ * @ingroup wayland
+ ******************************************************************************/
 class SurfaceManager
 {
 public:
@@ -61,10 +69,18 @@ public:
 
 private:
 
+	struct Index
+	{
+		std::unordered_map<std::string, wl_surface*> surfaces;
+		std::unordered_map<wl_surface*, std::string> connectors;
+	};
+
+	typedef std::shared_ptr<const Index> IndexPtr;
+
 	SurfaceManager();
 
 	std::list<SurfaceNotificationItf*> mSubscribers;
-	std::unordered_map<std::string, wl_surface*> mSurfaces;
+	IndexPtr mIndex;
 
 	XenBackend::Log mLog;
 
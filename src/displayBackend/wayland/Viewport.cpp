@@ -0,0 +1,90 @@
+/*
+ *  Wayland viewport
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "Viewport.hpp"
+
+#include "Exception.hpp"
+
+namespace Wayland {
+
+/*******************************************************************************
+ * Viewport
+ ******************************************************************************/
+
+Viewport::Viewport(wp_viewporter* viewporter, SurfacePtr surface) :
+	mWpViewport(nullptr),
+	mSurface(surface),
+	mLog("Viewport")
+{
+	try
+	{
+		init(viewporter);
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+Viewport::~Viewport()
+{
+	release();
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void Viewport::setDestination(uint32_t width, uint32_t height)
+{
+	LOG(mLog, DEBUG) << "Set destination, w: " << width << ", h: " << height;
+
+	wp_viewport_set_destination(mWpViewport, width, height);
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void Viewport::init(wp_viewporter* viewporter)
+{
+	mWpViewport = wp_viewporter_get_viewport(viewporter, mSurface->mWlSurface);
+
+	if (!mWpViewport)
+	{
+		throw Exception("Can't create viewport", errno);
+	}
+
+	LOG(mLog, DEBUG) << "Create";
+}
+
+void Viewport::release()
+{
+	if (mWpViewport)
+	{
+		wp_viewport_destroy(mWpViewport);
+
+		LOG(mLog, DEBUG) << "Delete";
+	}
+}
+
+}
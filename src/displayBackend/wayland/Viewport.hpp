@@ -0,0 +1,76 @@
+/*
+ *  Wayland viewport
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_WAYLAND_VIEWPORT_HPP_
+#define SRC_WAYLAND_VIEWPORT_HPP_
+
+#include <memory>
+
+#include <xen/be/Log.hpp>
+
+#include "Surface.hpp"
+#include "viewporter-client-protocol.h"
+
+namespace Wayland {
+
+/***************************************************************************//**
+ * Wayland viewport class.
+ * Scales the surface content on the compositor side.
+ * @ingroup wayland
+ ******************************************************************************/
+class Viewport
+{
+public:
+
+	~Viewport();
+
+	/**
+	 * Sets the surface size the content is scaled to.
+	 * Applied on the next surface commit.
+	 * @param width  width
+	 * @param height height
+	 */
+	void setDestination(uint32_t width, uint32_t height);
+
+	/**
+	 * Returns associated surface
+	 */
+	SurfacePtr getSurface() const { return mSurface; }
+
+private:
+
+	friend class Viewporter;
+
+	Viewport(wp_viewporter* viewporter, SurfacePtr surface);
+
+	wp_viewport* mWpViewport;
+	SurfacePtr mSurface;
+
+	XenBackend::Log mLog;
+
+	void init(wp_viewporter* viewporter);
+	void release();
+};
+
+typedef std::shared_ptr<Viewport> ViewportPtr;
+
+}
+
+#endif /* SRC_WAYLAND_VIEWPORT_HPP_ */
@@ -0,0 +1,90 @@
+/*
+ *  Wayland viewporter
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "Viewporter.hpp"
+
+#include "Exception.hpp"
+
+namespace Wayland {
+
+/*******************************************************************************
+ * Viewporter
+ ******************************************************************************/
+
+Viewporter::Viewporter(wl_registry* registry, uint32_t id, uint32_t version) :
+	Registry(registry, id, version),
+	mWpViewporter(nullptr),
+	mLog("Viewporter")
+{
+	try
+	{
+		init();
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+Viewporter::~Viewporter()
+{
+	release();
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+ViewportPtr Viewporter::createViewport(SurfacePtr surface)
+{
+	LOG(mLog, DEBUG) << "Create viewport";
+
+	return ViewportPtr(new Viewport(mWpViewporter, surface));
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void Viewporter::init()
+{
+	mWpViewporter = static_cast<wp_viewporter*>(
+			bind(&wp_viewporter_interface));
+
+	if (!mWpViewporter)
+	{
+		throw Exception("Can't bind viewporter", errno);
+	}
+
+	LOG(mLog, DEBUG) << "Create";
+}
+
+void Viewporter::release()
+{
+	if (mWpViewporter)
+	{
+		wp_viewporter_destroy(mWpViewporter);
+
+		LOG(mLog, DEBUG) << "Delete";
+	}
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+ *  Wayland viewporter
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_WAYLAND_VIEWPORTER_HPP_
+#define SRC_WAYLAND_VIEWPORTER_HPP_
+
+#include <xen/be/Log.hpp>
+
+#include "Registry.hpp"
+#include "Viewport.hpp"
+
+namespace Wayland {
+
+/***************************************************************************//**
+ * Wayland viewporter class.
+ * @ingroup wayland
+ ******************************************************************************/
+class Viewporter : public Registry
+{
+public:
+
+	~Viewporter();
+
+	/**
+	 * Creates viewport
+	 * @param surface surface
+	 */
+	ViewportPtr createViewport(SurfacePtr surface);
+
+private:
+
+	friend class Display;
+
+	Viewporter(wl_registry* registry, uint32_t id, uint32_t version);
+
+	wp_viewporter* mWpViewporter;
+	XenBackend::Log mLog;
+
+	void init();
+	void release();
+};
+
+typedef std::shared_ptr<Viewporter> ViewporterPtr;
+
+}
+
+#endif /* SRC_WAYLAND_VIEWPORTER_HPP_ */
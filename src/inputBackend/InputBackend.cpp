@@ -20,21 +20,37 @@
 
 #include "InputBackend.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
+#include <sys/mman.h>
+
+#include "InputGroup.hpp"
 #include "input/DevInput.hpp"
 #ifdef WITH_WAYLAND
 #include "input/WlInput.hpp"
 #endif
 
 using std::bind;
+using std::chrono::milliseconds;
+using std::find_if;
 using std::istringstream;
+using std::lock_guard;
+using std::max;
+using std::min;
+using std::mutex;
 using std::shared_ptr;
 using std::string;
+using std::strtol;
+using std::thread;
 using std::to_string;
 using std::toupper;
 using std::transform;
+using std::unique_lock;
+using std::unordered_map;
 using std::vector;
 
 using namespace std::placeholders;
@@ -57,19 +73,40 @@ using InputItf::TouchPtr;
 
 InputRingBuffer::InputRingBuffer(KeyboardPtr keyboard, PointerPtr pointer,
 								 TouchPtr touch, bool isReqAbs,
-								 bool isReqMTouch, domid_t domId,
-								 evtchn_port_t port, int ref,
+								 bool isReqMTouch,
+								 const AbsTransform& pointerTransform,
+								 const AbsTransform& touchTransform,
+								 domid_t domId, evtchn_port_t port, int ref,
 								 int offset, size_t size) :
 	RingBufferOutBase<xenkbd_page, xenkbd_in_event>(domId, port, ref,
 													offset, size),
 	mKeyboard(keyboard),
 	mPointer(pointer),
 	mTouch(touch),
-	mLog("InputRingBuffer")
+	mNumEvents(size / sizeof(xenkbd_in_event)),
+	mPageBuffer(domId, ref, PROT_READ),
+	mPage(static_cast<const xenkbd_page*>(mPageBuffer.get())),
+	mPointerTransform(pointerTransform),
+	mTouchTransform(touchTransform),
+	mLog("InputRingBuffer"),
+	mFrameEnd(0),
+	mTerminate(false),
+	mFrameCount(0),
+	mEventCount(0),
+	mMaxFrameSize(0),
+	mRingFullCount(0),
+	mCoalescedCount(0),
+	mDroppedCount(0),
+	mFailedCount(0)
 {
+	mEvents.reserve(XENKBD_IN_RING_LEN);
+
 	if (mKeyboard)
 	{
-		mKeyboard->setCallbacks({bind(&InputRingBuffer::onKey, this, _1, _2)});
+		mKeyboard->setCallbacks({
+			bind(&InputRingBuffer::onKey, this, _1, _2),
+			bind(&InputRingBuffer::onSync, this),
+		});
 	}
 
 	if (mPointer)
@@ -80,6 +117,7 @@ InputRingBuffer::InputRingBuffer(KeyboardPtr keyboard, PointerPtr pointer,
 				bind(&InputRingBuffer::onMoveRel, this, _1, _2, _3),
 				bind(&InputRingBuffer::onMoveAbs, this, _1, _2, _3),
 				bind(&InputRingBuffer::onButton, this, _1, _2),
+				bind(&InputRingBuffer::onSync, this),
 			});
 		}
 		else
@@ -88,6 +126,7 @@ InputRingBuffer::InputRingBuffer(KeyboardPtr keyboard, PointerPtr pointer,
 				bind(&InputRingBuffer::onMoveRel, this, _1, _2, _3),
 				nullptr,
 				bind(&InputRingBuffer::onButton, this, _1, _2),
+				bind(&InputRingBuffer::onSync, this),
 			});
 		}
 	}
@@ -99,18 +138,322 @@ InputRingBuffer::InputRingBuffer(KeyboardPtr keyboard, PointerPtr pointer,
 			bind(&InputRingBuffer::onUp, this, _1),
 			bind(&InputRingBuffer::onMotion, this, _1, _2, _3),
 			bind(&InputRingBuffer::onFrame, this, _1),
+			bind(&InputRingBuffer::onShape, this, _1, _2, _3),
+			bind(&InputRingBuffer::onOrientation, this, _1, _2),
 		});
 	}
 
+	mThread = thread(&InputRingBuffer::run, this);
+
 	LOG(mLog, DEBUG) << "Create, reqAbs: " << isReqAbs
 					 << ", reqMTouch: " << isReqMTouch;
 }
 
 InputRingBuffer::~InputRingBuffer()
 {
+	// the devices are deleted after the event queue, stop the callbacks first
+
+	if (mKeyboard)
+	{
+		mKeyboard->setCallbacks({});
+	}
+
+	if (mPointer)
+	{
+		mPointer->setCallbacks({});
+	}
+
+	if (mTouch)
+	{
+		mTouch->setCallbacks({});
+	}
+
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		mTerminate = true;
+
+		mCondVar.notify_one();
+	}
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	logStats();
+
 	LOG(mLog, DEBUG) << "Delete";
 }
 
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+size_t InputRingBuffer::getFreeEvents() const
+{
+	uint32_t used = mPage->in_prod - mPage->in_cons;
+
+	return used < mNumEvents ? mNumEvents - used : 0;
+}
+
+void InputRingBuffer::queueEvent(const xenkbd_in_event& event)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mEvents.push_back(event);
+
+	// don't hold more than the ring fits if the device doesn't send frames
+
+	if (mEvents.size() - mFrameEnd == XENKBD_IN_RING_LEN)
+	{
+		flushEvents();
+	}
+}
+
+void InputRingBuffer::flushEvents()
+{
+	auto frameSize = mEvents.size() - mFrameEnd;
+
+	if (!frameSize)
+	{
+		return;
+	}
+
+	DLOG(mLog, DEBUG) << "Flush events: " << frameSize;
+
+	mFrameEnd = mEvents.size();
+
+	mEventCount += frameSize;
+	mMaxFrameSize = max(mMaxFrameSize, frameSize);
+
+	if (++mFrameCount % cStatsPeriod == 0)
+	{
+		logStats();
+	}
+
+	pushEvents();
+}
+
+void InputRingBuffer::pushEvents()
+{
+	// libxenbe notifies the frontend on each sent event, so a frame of N
+	// events costs N notifications. The events are only pushed back to back,
+	// notifications still pending in the guest are merged.
+
+	size_t sent = 0;
+	size_t count = min(mFrameEnd, getFreeEvents());
+
+	if (count < mFrameEnd)
+	{
+		// the ring is full: keep the rest and retry later
+
+		mRingFullCount++;
+	}
+
+	try
+	{
+		for (; sent < count; sent++)
+		{
+			sendEvent(mEvents[sent]);
+		}
+	}
+	catch(const std::exception& e)
+	{
+		// retrying won't help: drop the queued frames
+
+		LOG(mLog, ERROR) << "Can't send events: " << e.what();
+
+		mFailedCount += mFrameEnd - sent;
+
+		sent = mFrameEnd;
+	}
+
+	mEvents.erase(mEvents.begin(), mEvents.begin() + sent);
+	mFrameEnd -= sent;
+
+	if (mFrameEnd)
+	{
+		coalesceEvents();
+		dropEvents();
+
+		mCondVar.notify_one();
+	}
+}
+
+void InputRingBuffer::coalesceEvents()
+{
+	vector<xenkbd_in_event> events;
+
+	events.reserve(mEvents.size());
+
+	// contact id and event type -> index of the contact last motion, shape
+	// or orientation, valid till the contact up/down
+	unordered_map<uint64_t, size_t> contacts;
+
+	auto contactKey = [](int32_t id, uint8_t type)
+	{
+		return static_cast<uint64_t>(static_cast<uint32_t>(id)) << 8 | type;
+	};
+
+	for (size_t i = 0; i < mFrameEnd; i++)
+	{
+		auto& event = mEvents[i];
+		auto last = events.empty() ? nullptr : &events.back();
+
+		if (event.type == XENKBD_TYPE_MOTION && last &&
+			last->type == XENKBD_TYPE_MOTION)
+		{
+			last->motion.rel_x += event.motion.rel_x;
+			last->motion.rel_y += event.motion.rel_y;
+			last->motion.rel_z += event.motion.rel_z;
+
+			mCoalescedCount++;
+
+			continue;
+		}
+
+		if (event.type == XENKBD_TYPE_POS && last &&
+			last->type == XENKBD_TYPE_POS)
+		{
+			last->pos.abs_x = event.pos.abs_x;
+			last->pos.abs_y = event.pos.abs_y;
+			last->pos.rel_z += event.pos.rel_z;
+
+			mCoalescedCount++;
+
+			continue;
+		}
+
+		if (event.type == XENKBD_TYPE_MTOUCH)
+		{
+			auto id = event.mtouch.contact_id;
+			auto key = contactKey(id, event.mtouch.event_type);
+
+			switch(event.mtouch.event_type)
+			{
+				case XENKBD_MT_EV_MOTION:
+				case XENKBD_MT_EV_SHAPE:
+				case XENKBD_MT_EV_ORIENT:
+				{
+					auto it = contacts.find(key);
+
+					if (it != contacts.end())
+					{
+						events[it->second].mtouch.u = event.mtouch.u;
+
+						mCoalescedCount++;
+
+						continue;
+					}
+
+					contacts[key] = events.size();
+
+					break;
+				}
+
+				case XENKBD_MT_EV_DOWN:
+				case XENKBD_MT_EV_UP:
+					contacts.erase(contactKey(id, XENKBD_MT_EV_MOTION));
+					contacts.erase(contactKey(id, XENKBD_MT_EV_SHAPE));
+					contacts.erase(contactKey(id, XENKBD_MT_EV_ORIENT));
+					break;
+
+				case XENKBD_MT_EV_SYN:
+					// the frame became empty
+					if (last && last->type == XENKBD_TYPE_MTOUCH &&
+						last->mtouch.event_type == XENKBD_MT_EV_SYN)
+					{
+						mCoalescedCount++;
+
+						continue;
+					}
+					break;
+			}
+		}
+
+		events.push_back(event);
+	}
+
+	auto frameEnd = events.size();
+
+	events.insert(events.end(), mEvents.begin() + mFrameEnd, mEvents.end());
+
+	mEvents.swap(events);
+	mFrameEnd = frameEnd;
+}
+
+void InputRingBuffer::dropEvents()
+{
+	auto isMotion = [](const xenkbd_in_event& event)
+	{
+		return event.type == XENKBD_TYPE_MOTION ||
+			   event.type == XENKBD_TYPE_POS ||
+			   (event.type == XENKBD_TYPE_MTOUCH &&
+				(event.mtouch.event_type == XENKBD_MT_EV_MOTION ||
+				 event.mtouch.event_type == XENKBD_MT_EV_SHAPE ||
+				 event.mtouch.event_type == XENKBD_MT_EV_ORIENT));
+	};
+
+	auto it = mEvents.begin();
+
+	while (mFrameEnd > cMaxQueuedEvents)
+	{
+		it = find_if(it, mEvents.begin() + mFrameEnd, isMotion);
+
+		if (it == mEvents.begin() + mFrameEnd)
+		{
+			break;
+		}
+
+		it = mEvents.erase(it);
+		mFrameEnd--;
+
+		mDroppedCount++;
+	}
+}
+
+void InputRingBuffer::logStats()
+{
+	if (!mFrameCount)
+	{
+		return;
+	}
+
+	LOG(mLog, DEBUG) << "Frames: " << mFrameCount
+					 << ", events: " << mEventCount
+					 << ", avg events per frame: "
+					 << static_cast<double>(mEventCount) / mFrameCount
+					 << ", max: " << mMaxFrameSize
+					 << ", ring full: " << mRingFullCount
+					 << ", coalesced: " << mCoalescedCount
+					 << ", dropped: " << mDroppedCount
+					 << ", failed: " << mFailedCount;
+}
+
+void InputRingBuffer::run()
+{
+	unique_lock<mutex> lock(mMutex);
+
+	while(!mTerminate)
+	{
+		if (mFrameEnd)
+		{
+			mCondVar.wait_for(lock, milliseconds(cRetryTimeoutMs),
+							  [this] { return mTerminate; });
+		}
+		else
+		{
+			mCondVar.wait(lock, [this] { return mFrameEnd || mTerminate; });
+		}
+
+		if (!mTerminate && mFrameEnd)
+		{
+			pushEvents();
+		}
+	}
+}
+
 void InputRingBuffer::onKey(uint32_t key, uint32_t state)
 {
 	DLOG(mLog, DEBUG) << "onKey key: " << key << ", state: " << state;
@@ -121,7 +464,7 @@ void InputRingBuffer::onKey(uint32_t key, uint32_t state)
 	event.key.keycode = key;
 	event.key.pressed = state;
 
-	sendEvent(event);
+	queueEvent(event);
 }
 
 void InputRingBuffer::onMoveRel(int32_t x, int32_t y, int32_t z)
@@ -135,13 +478,15 @@ void InputRingBuffer::onMoveRel(int32_t x, int32_t y, int32_t z)
 	event.motion.rel_y = y;
 	event.motion.rel_z = z;
 
-	sendEvent(event);
+	queueEvent(event);
 }
 
 void InputRingBuffer::onMoveAbs(int32_t x, int32_t y, int32_t z)
 {
 	DLOG(mLog, DEBUG) << "onMoveAbs x: " << x << ", y: " << y << ", z: " << z;
 
+	mPointerTransform.apply(x, y);
+
 	xenkbd_in_event event = {};
 
 	event.type = XENKBD_TYPE_POS;
@@ -149,7 +494,7 @@ void InputRingBuffer::onMoveAbs(int32_t x, int32_t y, int32_t z)
 	event.pos.abs_y = y;
 	event.pos.rel_z = z;
 
-	sendEvent(event);
+	queueEvent(event);
 }
 
 void InputRingBuffer::onButton(uint32_t button, uint32_t state)
@@ -162,13 +507,24 @@ void InputRingBuffer::onButton(uint32_t button, uint32_t state)
 	event.key.keycode = button;
 	event.key.pressed = state;
 
-	sendEvent(event);
+	queueEvent(event);
+}
+
+void InputRingBuffer::onSync()
+{
+	DLOG(mLog, DEBUG) << "onSync";
+
+	lock_guard<mutex> lock(mMutex);
+
+	flushEvents();
 }
 
 void InputRingBuffer::onDown(int32_t id, int32_t x, int32_t y)
 {
 	DLOG(mLog, DEBUG) << "onDown id: " << id << ", x: " << x << ", y: " << y;
 
+	mTouchTransform.apply(x, y);
+
 	xenkbd_in_event event = {};
 
 	event.type = XENKBD_TYPE_MTOUCH;
@@ -176,7 +532,7 @@ void InputRingBuffer::onDown(int32_t id, int32_t x, int32_t y)
 	event.mtouch.contact_id = id;
 	event.mtouch.u.pos = {x, y};
 
-	sendEvent(event);
+	queueEvent(event);
 }
 
 void InputRingBuffer::onUp(int32_t id)
@@ -189,13 +545,15 @@ void InputRingBuffer::onUp(int32_t id)
 	event.mtouch.event_type = XENKBD_MT_EV_UP;
 	event.mtouch.contact_id = id;
 
-	sendEvent(event);
+	queueEvent(event);
 }
 
 void InputRingBuffer::onMotion(int32_t id, int32_t x, int32_t y)
 {
 	DLOG(mLog, DEBUG) << "onMotion id: " << id << ", x: " << x << ", y: " << y;
 
+	mTouchTransform.apply(x, y);
+
 	xenkbd_in_event event = {};
 
 	event.type = XENKBD_TYPE_MTOUCH;
@@ -203,7 +561,7 @@ void InputRingBuffer::onMotion(int32_t id, int32_t x, int32_t y)
 	event.mtouch.contact_id = id;
 	event.mtouch.u.pos = {x, y};
 
-	sendEvent(event);
+	queueEvent(event);
 }
 
 void InputRingBuffer::onFrame(int32_t id)
@@ -216,7 +574,41 @@ void InputRingBuffer::onFrame(int32_t id)
 	event.mtouch.event_type = XENKBD_MT_EV_SYN;
 	event.mtouch.contact_id = id;
 
-	sendEvent(event);
+	lock_guard<mutex> lock(mMutex);
+
+	mEvents.push_back(event);
+
+	flushEvents();
+}
+
+void InputRingBuffer::onShape(int32_t id, uint32_t major, uint32_t minor)
+{
+	DLOG(mLog, DEBUG) << "onShape id: " << id << ", major: " << major
+					  << ", minor: " << minor;
+
+	xenkbd_in_event event = {};
+
+	event.type = XENKBD_TYPE_MTOUCH;
+	event.mtouch.event_type = XENKBD_MT_EV_SHAPE;
+	event.mtouch.contact_id = id;
+	event.mtouch.u.shape = {major, minor};
+
+	queueEvent(event);
+}
+
+void InputRingBuffer::onOrientation(int32_t id, int32_t orientation)
+{
+	DLOG(mLog, DEBUG) << "onOrientation id: " << id
+					  << ", orientation: " << orientation;
+
+	xenkbd_in_event event = {};
+
+	event.type = XENKBD_TYPE_MTOUCH;
+	event.mtouch.event_type = XENKBD_MT_EV_ORIENT;
+	event.mtouch.contact_id = id;
+	event.mtouch.u.orientation = orientation;
+
+	queueEvent(event);
 }
 
 
@@ -244,9 +636,11 @@ void InputFrontendHandler::onBind()
 	auto id = getXenStore().readString(getXsBackendPath() + "/" XENKBD_FIELD_UNIQUE_ID);
 
 	bool isReqAbs = false;
+	bool isReqRaw = false;
 	bool isReqMTouch = false;
 
 	string reqAbsPath = getXsBackendPath() + "/" XENKBD_FIELD_REQ_ABS_POINTER;
+	string reqRawPath = getXsFrontendPath() + "/" XENKBD_FIELD_REQ_RAW_POINTER;
 	string reqMTouchPath = getXsFrontendPath() + "/" XENKBD_FIELD_REQ_MTOUCH;
 
 	if (getXenStore().checkIfExist(reqAbsPath))
@@ -254,6 +648,13 @@ void InputFrontendHandler::onBind()
 		isReqAbs = getXenStore().readInt(reqAbsPath);
 	}
 
+	// raw coordinates are valid only along with absolute ones
+
+	if (isReqAbs && getXenStore().checkIfExist(reqRawPath))
+	{
+		isReqRaw = getXenStore().readInt(reqRawPath);
+	}
+
 	if (getXenStore().checkIfExist(reqMTouchPath))
 	{
 		isReqMTouch = getXenStore().readInt(reqMTouchPath);
@@ -263,11 +664,34 @@ void InputFrontendHandler::onBind()
 
 	parseInputId(id, keyboardId, pointerId, touchId);
 
+	auto pointerRotation = parseRotation(pointerId);
+	auto touchRotation = parseRotation(touchId);
+
+	auto pointer = createInputDevice<PointerCallbacks>(pointerId);
+	auto touch = createInputDevice<TouchCallbacks>(touchId);
+
+	AbsTransform pointerTransform, touchTransform;
+
+	if (pointer && isReqAbs)
+	{
+		pointerTransform = createTransform(pointer,
+										   readSize(XENKBD_FIELD_WIDTH),
+										   readSize(XENKBD_FIELD_HEIGHT),
+										   isReqRaw, pointerRotation);
+	}
+
+	if (touch && isReqMTouch)
+	{
+		touchTransform = createTransform(touch,
+										 readSize(XENKBD_FIELD_MT_WIDTH),
+										 readSize(XENKBD_FIELD_MT_HEIGHT),
+										 false, touchRotation);
+	}
+
 	InputRingBufferPtr eventRingBuffer(
 			new InputRingBuffer(createInputDevice<KeyboardCallbacks>(keyboardId),
-								createInputDevice<PointerCallbacks>(pointerId),
-								createInputDevice<TouchCallbacks>(touchId),
-								isReqAbs, isReqMTouch,
+								pointer, touch, isReqAbs, isReqMTouch,
+								pointerTransform, touchTransform,
 								getDomId(), port, ref,
 								XENKBD_IN_RING_OFFS, XENKBD_IN_RING_SIZE));
 
@@ -310,17 +734,132 @@ void InputFrontendHandler::parseInputId(const string& id, string& keyboardId,
 	}
 }
 
+int InputFrontendHandler::parseRotation(string& id)
+{
+	auto pos = id.rfind('@');
+
+	if (pos == string::npos)
+	{
+		return 0;
+	}
+
+	// merged devices may have different orientations
+
+	if (id.find(',') != string::npos)
+	{
+		throw XenBackend::Exception("Rotation is not supported for device "
+									"groups: " + id, EINVAL);
+	}
+
+	auto val = id.substr(pos + 1);
+	char* end = nullptr;
+	auto rotation = strtol(val.c_str(), &end, 10);
+
+	if (val.empty() || *end != '\0' || !AbsTransform::isRotation(rotation))
+	{
+		throw XenBackend::Exception("Invalid rotation: " + val + " in id",
+									EINVAL);
+	}
+
+	id.erase(pos);
+
+	return rotation;
+}
+
+uint32_t InputFrontendHandler::readSize(const string& field)
+{
+	string path = getXsBackendPath() + "/" + field;
+
+	if (!getXenStore().checkIfExist(path))
+	{
+		return 0;
+	}
+
+	return getXenStore().readUint(path);
+}
+
+template<typename T>
+AbsTransform InputFrontendHandler::createTransform(
+		shared_ptr<InputItf::InputDevice<T>> device,
+		uint32_t width, uint32_t height, bool isRaw, int rotation)
+{
+	InputItf::AbsRange src, dst;
+
+	bool hasSrc = device->getAbsRange(src);
+	bool hasDst = width && height;
+
+	if (isRaw)
+	{
+		dst = { 0, cRawAbsMax, 0, cRawAbsMax };
+	}
+	else if (hasDst)
+	{
+		dst = { 0, static_cast<int32_t>(width),
+				0, static_cast<int32_t>(height) };
+	}
+	else if (hasSrc)
+	{
+		// rotate in the device range
+		dst = src;
+	}
+	else
+	{
+		LOG(mLog, DEBUG) << "Positions are not transformed: unknown range";
+
+		return AbsTransform();
+	}
+
+	if (!hasSrc)
+	{
+		// Wayland positions are already in the frontend surface pixels
+
+		if (isRaw && !hasDst)
+		{
+			LOG(mLog, WARNING) << "Raw positions require width and height";
+
+			return AbsTransform();
+		}
+
+		bool isSwapped = rotation == 90 || rotation == 270;
+
+		src = { 0, static_cast<int32_t>(isSwapped ? height : width),
+				0, static_cast<int32_t>(isSwapped ? width : height) };
+	}
+
+	if (!isRaw && rotation == 0 &&
+		src.minX == dst.minX && src.maxX == dst.maxX &&
+		src.minY == dst.minY && src.maxY == dst.maxY)
+	{
+		return AbsTransform();
+	}
+
+	LOG(mLog, DEBUG) << "Transform positions, src: [" << src.minX << ", "
+					 << src.maxX << "] x [" << src.minY << ", " << src.maxY
+					 << "], dst: [" << dst.minX << ", " << dst.maxX << "] x ["
+					 << dst.minY << ", " << dst.maxY << "], rotation: "
+					 << rotation;
+
+	return AbsTransform(src, dst, rotation);
+}
+
 template<typename T>
 shared_ptr<InputItf::InputDevice<T>>
 InputFrontendHandler::createInputDevice(const string& id)
 {
+	if (id.find(',') != string::npos)
+	{
+		return createInputGroup<T>(id);
+	}
+
 	if (!id.empty())
 	{
 		LOG(mLog, DEBUG) << "Create input device : " << id;
 
-		if (id[0] == '/')
+		if (id[0] == '/' || InputReplay::isReplay(id) ||
+			EvdevDevice::isUdevId(id))
 		{
-			return shared_ptr<InputItf::InputDevice<T>>(new DevInput<T>(id));
+			return shared_ptr<InputItf::InputDevice<T>>(
+					new DevInput<T>(id, getDomId()));
 		}
 #ifdef WITH_WAYLAND
 		else if (mDisplay)
@@ -334,6 +873,40 @@ InputFrontendHandler::createInputDevice(const string& id)
 	return shared_ptr<InputItf::InputDevice<T>>();
 }
 
+template<typename T>
+shared_ptr<InputItf::InputDevice<T>>
+InputFrontendHandler::createInputGroup(const string& id)
+{
+	istringstream input(id);
+	string token;
+
+	vector<typename InputGroup<T>::DevicePtr> devices;
+
+	LOG(mLog, DEBUG) << "Create input group : " << id;
+
+	while (getline(input, token, ','))
+	{
+		auto device = createInputDevice<T>(token);
+
+		if (device)
+		{
+			devices.push_back(device);
+		}
+	}
+
+	if (devices.size() < 2)
+	{
+		return devices.empty() ? nullptr : devices.front();
+	}
+
+	// the frontend assumes one contact if the number is not set
+
+	auto numContacts = readSize(XENKBD_FIELD_MT_NUM_CONTACTS);
+
+	return shared_ptr<InputItf::InputDevice<T>>(
+			new InputGroup<T>(devices, numContacts ? numContacts : 1));
+}
+
 /*******************************************************************************
  * DisplayBackend
  ******************************************************************************/
@@ -21,13 +21,20 @@
 #ifndef INPUTBACKEND_HPP_
 #define INPUTBACKEND_HPP_
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <xen/be/BackendBase.hpp>
 #include <xen/be/FrontendHandlerBase.hpp>
 #include <xen/be/Log.hpp>
+#include <xen/be/XenGnttab.hpp>
 
 #include "kbdif.h"
 
 #include "InputItf.hpp"
+#include "InputTransform.hpp"
 
 #ifdef WITH_WAYLAND
 #include "wayland/Display.hpp"
@@ -40,6 +47,20 @@
 
 /***************************************************************************//**
  * Ring buffer used to send events to the frontend.
+ * Events are queued till the end of the input frame they belong to and then
+ * pushed to the ring back to back. Each event still notifies the frontend
+ * as libxenbe doesn't allow to push several events with one notification.
+ * Events per frame statistics are logged every cStatsPeriod frames and on
+ * delete.
+ * If the ring is full, complete frames stay queued and are pushed again every
+ * cRetryTimeoutMs. Meanwhile, consecutive relative motions are merged and
+ * only the latest value is kept for absolute and touch motions, touch shapes
+ * and orientations. If the queue still exceeds cMaxQueuedEvents, the oldest
+ * of them are dropped. Key, button and touch down/up events are never merged
+ * nor dropped. Events which fail to be sent for another reason than a full
+ * ring are dropped.
+ * Absolute pointer and touch positions are transformed to the frontend range
+ * before queueing.
  * @ingroup input_be
  ******************************************************************************/
 class InputRingBuffer : public XenBackend::RingBufferOutBase<xenkbd_page,
@@ -52,6 +73,8 @@ public:
 	 * @param touch       input touch instance
 	 * @param isReqAbs    request pointer absolute coordinates
 	 * @param isReqMTouch request multi touch support
+	 * @param pointerTransform pointer absolute position transform
+	 * @param touchTransform   touch position transform
 	 * @param domId       frontend domain id
 	 * @param port        event channel port number
 	 * @param ref         grant table reference
@@ -62,6 +85,8 @@ public:
 					InputItf::PointerPtr pointer,
 					InputItf::TouchPtr touch,
 					bool isReqAbs, bool isReqMTouch,
+					const AbsTransform& pointerTransform,
+					const AbsTransform& touchTransform,
 					domid_t domId, evtchn_port_t port, int ref,
 					int offset, size_t size);
 
@@ -69,23 +94,64 @@ public:
 
 private:
 
+	const uint64_t cStatsPeriod = 1000;
+	const uint32_t cRetryTimeoutMs = 10;
+	const size_t cMaxQueuedEvents = 4 * XENKBD_IN_RING_LEN;
+
 	InputItf::KeyboardPtr mKeyboard;
 	InputItf::PointerPtr mPointer;
 	InputItf::TouchPtr mTouch;
 
+	size_t mNumEvents;
+	// read only mapping of the event page to check the ring indexes
+	XenBackend::XenGnttabBuffer mPageBuffer;
+	const xenkbd_page* mPage;
+
+	AbsTransform mPointerTransform;
+	AbsTransform mTouchTransform;
+
 	XenBackend::Log mLog;
 
+	// events of complete frames are [0, mFrameEnd)
+	std::vector<xenkbd_in_event> mEvents;
+	size_t mFrameEnd;
+	bool mTerminate;
+	uint64_t mFrameCount;
+	uint64_t mEventCount;
+	size_t mMaxFrameSize;
+	uint64_t mRingFullCount;
+	uint64_t mCoalescedCount;
+	uint64_t mDroppedCount;
+	uint64_t mFailedCount;
+
+	std::mutex mMutex;
+	std::condition_variable mCondVar;
+	std::thread mThread;
+
+	size_t getFreeEvents() const;
+	void queueEvent(const xenkbd_in_event& event);
+	void flushEvents();
+	void pushEvents();
+	void coalesceEvents();
+	void dropEvents();
+	void logStats();
+	void run();
+
 	// keyboard
 	void onKey(uint32_t key, uint32_t state);
 	// pointer
 	void onMoveRel(int32_t x, int32_t y, int32_t z);
 	void onMoveAbs(int32_t x, int32_t y, int32_t z);
 	void onButton(uint32_t button, uint32_t state);
+	// keyboard and pointer
+	void onSync();
 	// touch
 	void onDown(int32_t id, int32_t x, int32_t y);
 	void onUp(int32_t id);
 	void onMotion(int32_t id, int32_t x, int32_t y);
 	void onFrame(int32_t id);
+	void onShape(int32_t id, uint32_t major, uint32_t minor);
+	void onOrientation(int32_t id, int32_t orientation);
 };
 
 typedef std::shared_ptr<InputRingBuffer> InputRingBufferPtr;
@@ -123,6 +189,8 @@ protected:
 
 private:
 
+	const int32_t cRawAbsMax = 0x7fff;
+
 	XenBackend::Log mLog;
 
 #ifdef WITH_WAYLAND
@@ -131,10 +199,22 @@ private:
 
 	void parseInputId(const std::string& id, std::string& keyboardId,
 					  std::string& pointerId, std::string& touchId);
+	int parseRotation(std::string& id);
+
+	uint32_t readSize(const std::string& field);
+
+	template<typename T>
+	AbsTransform createTransform(
+			std::shared_ptr<InputItf::InputDevice<T>> device,
+			uint32_t width, uint32_t height, bool isRaw, int rotation);
 
 	template<typename T>
 	std::shared_ptr<InputItf::InputDevice<T>>
 			createInputDevice(const std::string& id);
+
+	template<typename T>
+	std::shared_ptr<InputItf::InputDevice<T>>
+			createInputGroup(const std::string& id);
 };
 
 /***************************************************************************//**
@@ -0,0 +1,311 @@
+/*
+ *  Input device group
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputGroup.hpp"
+
+using std::lock_guard;
+using std::make_pair;
+using std::mutex;
+using std::vector;
+
+using InputItf::AbsRange;
+using InputItf::KeyboardCallbacks;
+using InputItf::PointerCallbacks;
+using InputItf::TouchCallbacks;
+
+/*******************************************************************************
+ * ContactIds
+ ******************************************************************************/
+
+ContactIds::ContactIds(uint32_t numContacts)
+{
+	// the lowest ids are allocated first
+
+	for (int32_t id = numContacts; id > 0; id--)
+	{
+		mFreeIds.push_back(id - 1);
+	}
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+bool ContactIds::allocate(size_t device, int32_t id, int32_t& groupId)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto key = make_pair(device, id);
+	auto it = mIds.find(key);
+
+	// down of the contact which is already down keeps its id
+
+	if (it != mIds.end())
+	{
+		groupId = it->second;
+
+		return true;
+	}
+
+	if (mFreeIds.empty())
+	{
+		return false;
+	}
+
+	groupId = mFreeIds.back();
+
+	mFreeIds.pop_back();
+
+	mIds[key] = groupId;
+
+	return true;
+}
+
+bool ContactIds::get(size_t device, int32_t id, int32_t& groupId)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto it = mIds.find(make_pair(device, id));
+
+	if (it == mIds.end())
+	{
+		return false;
+	}
+
+	groupId = it->second;
+
+	return true;
+}
+
+bool ContactIds::free(size_t device, int32_t id, int32_t& groupId)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto it = mIds.find(make_pair(device, id));
+
+	if (it == mIds.end())
+	{
+		return false;
+	}
+
+	groupId = it->second;
+
+	mFreeIds.push_back(groupId);
+	mIds.erase(it);
+
+	return true;
+}
+
+/*******************************************************************************
+ * InputGroup
+ ******************************************************************************/
+
+template<typename T>
+InputGroup<T>::InputGroup(const vector<DevicePtr>& devices,
+						  uint32_t numContacts) :
+	mDevices(devices),
+	mTransforms(devices.size()),
+	mHasRange(false),
+	mRange(),
+	mContactIds(new ContactIds(numContacts))
+{
+	for (size_t i = 0; i < mDevices.size(); i++)
+	{
+		AbsRange range;
+
+		if (!mDevices[i]->getAbsRange(range))
+		{
+			continue;
+		}
+
+		if (!mHasRange)
+		{
+			mRange = range;
+			mHasRange = true;
+
+			continue;
+		}
+
+		if (range.minX != mRange.minX || range.maxX != mRange.maxX ||
+			range.minY != mRange.minY || range.maxY != mRange.maxY)
+		{
+			mTransforms[i] = AbsTransform(range, mRange, 0);
+		}
+	}
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+template<typename T>
+void InputGroup<T>::setCallbacks(const T& callbacks)
+{
+	for (size_t i = 0; i < mDevices.size(); i++)
+	{
+		mDevices[i]->setCallbacks(wrapCallbacks(callbacks, i));
+	}
+}
+
+template<typename T>
+bool InputGroup<T>::getAbsRange(AbsRange& range)
+{
+	if (mHasRange)
+	{
+		range = mRange;
+	}
+
+	return mHasRange;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+template<>
+KeyboardCallbacks InputGroup<KeyboardCallbacks>::wrapCallbacks(
+		const KeyboardCallbacks& callbacks, size_t index)
+{
+	return callbacks;
+}
+
+template<>
+PointerCallbacks InputGroup<PointerCallbacks>::wrapCallbacks(
+		const PointerCallbacks& callbacks, size_t index)
+{
+	auto wrapped = callbacks;
+	auto transform = mTransforms[index];
+
+	if (callbacks.moveAbsolute)
+	{
+		wrapped.moveAbsolute = [callbacks, transform]
+							   (int32_t x, int32_t y, int32_t relZ)
+		{
+			transform.apply(x, y);
+			callbacks.moveAbsolute(x, y, relZ);
+		};
+	}
+
+	return wrapped;
+}
+
+template<>
+TouchCallbacks InputGroup<TouchCallbacks>::wrapCallbacks(
+		const TouchCallbacks& callbacks, size_t index)
+{
+	auto transform = mTransforms[index];
+	auto contactIds = mContactIds;
+
+	// Unset callbacks stay unset. Events of contacts without group id are
+	// dropped.
+
+	auto wrapped = callbacks;
+
+	if (callbacks.down)
+	{
+		wrapped.down = [callbacks, contactIds, index, transform]
+					   (int32_t id, int32_t x, int32_t y)
+		{
+			int32_t groupId;
+
+			if (contactIds->allocate(index, id, groupId))
+			{
+				transform.apply(x, y);
+				callbacks.down(groupId, x, y);
+			}
+		};
+	}
+
+	if (callbacks.up)
+	{
+		wrapped.up = [callbacks, contactIds, index](int32_t id)
+		{
+			int32_t groupId;
+
+			if (contactIds->free(index, id, groupId))
+			{
+				callbacks.up(groupId);
+			}
+		};
+	}
+
+	if (callbacks.motion)
+	{
+		wrapped.motion = [callbacks, contactIds, index, transform]
+						 (int32_t id, int32_t x, int32_t y)
+		{
+			int32_t groupId;
+
+			if (contactIds->get(index, id, groupId))
+			{
+				transform.apply(x, y);
+				callbacks.motion(groupId, x, y);
+			}
+		};
+	}
+
+	if (callbacks.frame)
+	{
+		wrapped.frame = [callbacks, contactIds, index](int32_t id)
+		{
+			// the frame may follow the contact up, send it with a valid id
+
+			int32_t groupId = 0;
+
+			contactIds->get(index, id, groupId);
+
+			callbacks.frame(groupId);
+		};
+	}
+
+	if (callbacks.shape)
+	{
+		wrapped.shape = [callbacks, contactIds, index]
+						(int32_t id, uint32_t major, uint32_t minor)
+		{
+			int32_t groupId;
+
+			if (contactIds->get(index, id, groupId))
+			{
+				callbacks.shape(groupId, major, minor);
+			}
+		};
+	}
+
+	if (callbacks.orientation)
+	{
+		wrapped.orientation = [callbacks, contactIds, index]
+							  (int32_t id, int32_t orientation)
+		{
+			int32_t groupId;
+
+			if (contactIds->get(index, id, groupId))
+			{
+				callbacks.orientation(groupId, orientation);
+			}
+		};
+	}
+
+	return wrapped;
+}
+
+template class InputGroup<KeyboardCallbacks>;
+template class InputGroup<PointerCallbacks>;
+template class InputGroup<TouchCallbacks>;
@@ -0,0 +1,121 @@
+/*
+ *  Input device group
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUTGROUP_HPP_
+#define SRC_INPUTGROUP_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "InputItf.hpp"
+#include "InputTransform.hpp"
+
+/***************************************************************************//**
+ * Maps touch contact ids of several devices to ids of one device.
+ * The frontend accepts contact ids in [0, number of contacts - 1] range. An
+ * id from this range is allocated on contact down and freed on contact up.
+ * If all ids are allocated, events of the contact are dropped till its up.
+ * @ingroup input_be
+ ******************************************************************************/
+class ContactIds
+{
+public:
+
+	/**
+	 * @param numContacts number of contacts supported by the frontend
+	 */
+	ContactIds(uint32_t numContacts);
+
+	/**
+	 * Allocates group id for the device contact
+	 * @param device  device index
+	 * @param id      device contact id
+	 * @param groupId allocated group contact id
+	 * @return false if there is no free id
+	 */
+	bool allocate(size_t device, int32_t id, int32_t& groupId);
+
+	/**
+	 * Gets group id of the device contact
+	 * @param device  device index
+	 * @param id      device contact id
+	 * @param groupId group contact id
+	 * @return false if the contact has no group id
+	 */
+	bool get(size_t device, int32_t id, int32_t& groupId);
+
+	/**
+	 * Frees group id of the device contact
+	 * @param device  device index
+	 * @param id      device contact id
+	 * @param groupId freed group contact id
+	 * @return false if the contact has no group id
+	 */
+	bool free(size_t device, int32_t id, int32_t& groupId);
+
+private:
+
+	// device index, device contact id -> group contact id
+	std::map<std::pair<size_t, int32_t>, int32_t> mIds;
+	std::vector<int32_t> mFreeIds;
+
+	std::mutex mMutex;
+};
+
+/***************************************************************************//**
+ * Merges several input devices into one.
+ * Callbacks set to the group are called by all its devices, so events of
+ * several physical devices go to one frontend ring. Absolute positions are
+ * mapped to the range of the first device which has it. Touch contact ids
+ * of all devices are mapped to the frontend range by ContactIds.
+ * @ingroup input_be
+ ******************************************************************************/
+template<typename T>
+class InputGroup : public InputItf::InputDevice<T>
+{
+public:
+
+	typedef std::shared_ptr<InputItf::InputDevice<T>> DevicePtr;
+
+	/**
+	 * @param devices     devices to merge
+	 * @param numContacts number of touch contacts supported by the frontend
+	 */
+	InputGroup(const std::vector<DevicePtr>& devices, uint32_t numContacts);
+
+	void setCallbacks(const T& callbacks) override;
+
+	bool getAbsRange(InputItf::AbsRange& range) override;
+
+private:
+
+	std::vector<DevicePtr> mDevices;
+	// device range -> group range
+	std::vector<AbsTransform> mTransforms;
+	bool mHasRange;
+	InputItf::AbsRange mRange;
+	std::shared_ptr<ContactIds> mContactIds;
+
+	T wrapCallbacks(const T& callbacks, size_t index);
+};
+
+#endif /* SRC_INPUTGROUP_HPP_ */
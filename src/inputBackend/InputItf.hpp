@@ -22,6 +22,7 @@
 #define SRC_INPUTITF_HPP_
 
 #include <exception>
+#include <functional>
 #include <memory>
 
 namespace InputItf {
@@ -31,9 +32,30 @@ namespace InputItf {
  * Abstract classes for input devices implementation.
  ******************************************************************************/
 
+/*
+ * The frame callback ends a group of events which are delivered to the
+ * frontend together, i.e. EV_SYN for evdev or wl_pointer.frame for wayland.
+ */
+
+/*
+ * Absolute positions are reported in device or surface units, they are
+ * scaled by the consumer using the device AbsRange. Relative motion is not
+ * accelerated nor rounded by the backend: fractional parts are accumulated
+ * till they make a whole unit.
+ */
+
+struct AbsRange
+{
+	int32_t minX;
+	int32_t maxX;
+	int32_t minY;
+	int32_t maxY;
+};
+
 struct KeyboardCallbacks
 {
 	std::function<void(uint32_t key, uint32_t state)> key;
+	std::function<void()> frame;
 };
 
 struct PointerCallbacks
@@ -41,6 +63,7 @@ struct PointerCallbacks
 	std::function<void(int32_t x, int32_t y, int32_t relZ)> moveRelative;
 	std::function<void(int32_t x, int32_t y, int32_t relZ)> moveAbsolute;
 	std::function<void(uint32_t button, uint32_t state)> button;
+	std::function<void()> frame;
 };
 
 struct TouchCallbacks
@@ -49,6 +72,9 @@ struct TouchCallbacks
 	std::function<void(int32_t id)> up;
 	std::function<void(int32_t id, int32_t x, int32_t y)> motion;
 	std::function<void(int32_t id)> frame;
+	std::function<void(int32_t id, uint32_t major, uint32_t minor)> shape;
+	// clockwise angle of the major axis in degrees
+	std::function<void(int32_t id, int32_t orientation)> orientation;
 };
 
 template<typename T>
@@ -58,6 +84,13 @@ public:
 	virtual ~InputDevice() {}
 
 	virtual void setCallbacks(const T& callbacks) = 0;
+
+	/**
+	 * Gets range of absolute positions
+	 * @param range range
+	 * @return false if the range is unknown
+	 */
+	virtual bool getAbsRange(AbsRange& range) { return false; }
 };
 
 typedef InputDevice<KeyboardCallbacks> Keyboard;
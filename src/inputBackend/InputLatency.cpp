@@ -0,0 +1,179 @@
+/*
+ *  Input latency
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputLatency.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <sstream>
+
+using std::lock_guard;
+using std::max;
+using std::mutex;
+using std::ostringstream;
+using std::string;
+
+/*******************************************************************************
+ * LatencyHistogram
+ ******************************************************************************/
+
+LatencyHistogram::LatencyHistogram(const string& name) :
+	mName(name),
+	mCount(0),
+	mSkipped(0),
+	mSum(0),
+	mMax(0),
+	mBuckets(),
+	mLog("InputLatency")
+{
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void LatencyHistogram::addSince(uint64_t timeUs)
+{
+	auto current = now();
+
+	lock_guard<mutex> lock(mMutex);
+
+	if (timeUs > current || current - timeUs > cMaxLatencyUs)
+	{
+		mSkipped++;
+
+		return;
+	}
+
+	auto latency = current - timeUs;
+	int bucket = 0;
+
+	while (bucket < cNumBuckets - 1 && latency >> (bucket + 1))
+	{
+		bucket++;
+	}
+
+	mBuckets[bucket]++;
+
+	mCount++;
+	mSum += latency;
+	mMax = max(mMax, latency);
+
+	DLOG(mLog, DEBUG) << mName << ", latency: " << latency << " us";
+}
+
+void LatencyHistogram::dump()
+{
+	lock_guard<mutex> lock(mMutex);
+
+	if (!mCount)
+	{
+		LOG(mLog, INFO) << mName << ", no events, skipped: " << mSkipped;
+
+		return;
+	}
+
+	ostringstream buckets;
+
+	for (int i = 0; i < cNumBuckets; i++)
+	{
+		if (mBuckets[i])
+		{
+			buckets << " <" << (1ull << (i + 1)) << ":" << mBuckets[i];
+		}
+	}
+
+	LOG(mLog, INFO) << mName << ", events: " << mCount
+					 << ", skipped: " << mSkipped
+					 << ", avg: " << mSum / mCount
+					 << " us, p50: <" << getPercentile(50)
+					 << " us, p99: <" << getPercentile(99)
+					 << " us, max: " << mMax << " us, buckets (us):"
+					 << buckets.str();
+}
+
+uint64_t LatencyHistogram::now()
+{
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+uint64_t LatencyHistogram::getPercentile(uint32_t percent) const
+{
+	uint64_t count = 0;
+
+	for (int i = 0; i < cNumBuckets; i++)
+	{
+		count += mBuckets[i];
+
+		if (count * 100 >= mCount * percent)
+		{
+			return 1ull << (i + 1);
+		}
+	}
+
+	return mMax;
+}
+
+/*******************************************************************************
+ * InputLatency
+ ******************************************************************************/
+
+InputLatency& InputLatency::getInstance()
+{
+	static InputLatency sInputLatency;
+
+	return sInputLatency;
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+LatencyHistogramPtr InputLatency::getHistogram(const string& name)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto& histogram = mHistograms[name];
+
+	if (!histogram)
+	{
+		histogram.reset(new LatencyHistogram(name));
+	}
+
+	return histogram;
+}
+
+void InputLatency::dump()
+{
+	lock_guard<mutex> lock(mMutex);
+
+	for (auto& histogram : mHistograms)
+	{
+		histogram.second->dump();
+	}
+}
@@ -0,0 +1,118 @@
+/*
+ *  Input latency
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUTLATENCY_HPP_
+#define SRC_INPUTLATENCY_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <xen/be/Log.hpp>
+
+/***************************************************************************//**
+ * Latency histogram of one input device.
+ * Latency is measured from the event timestamp till the event frame is pushed
+ * to the frontend ring. Bucket i counts latencies in [2^i, 2^(i+1)) us.
+ * @ingroup input_be
+ ******************************************************************************/
+class LatencyHistogram
+{
+public:
+
+	/**
+	 * @param name device name
+	 */
+	LatencyHistogram(const std::string& name);
+
+	/**
+	 * Adds latency from the timestamp till now
+	 * @param timeUs CLOCK_MONOTONIC timestamp in us
+	 */
+	void addSince(uint64_t timeUs);
+
+	/**
+	 * Logs the histogram
+	 */
+	void dump();
+
+	/**
+	 * Returns CLOCK_MONOTONIC time in us
+	 */
+	static uint64_t now();
+
+private:
+
+	static const int cNumBuckets = 24;
+	// timestamps of another clock base are skipped
+	const uint64_t cMaxLatencyUs = 10000000;
+
+	std::string mName;
+	uint64_t mCount;
+	uint64_t mSkipped;
+	uint64_t mSum;
+	uint64_t mMax;
+	uint64_t mBuckets[cNumBuckets];
+	XenBackend::Log mLog;
+
+	std::mutex mMutex;
+
+	uint64_t getPercentile(uint32_t percent) const;
+};
+
+typedef std::shared_ptr<LatencyHistogram> LatencyHistogramPtr;
+
+/***************************************************************************//**
+ * Keeps latency histograms of all input devices.
+ * Histograms are shared by devices with the same name and kept till exit, so
+ * they accumulate across frontends reconnection.
+ * @ingroup input_be
+ ******************************************************************************/
+class InputLatency
+{
+public:
+
+	InputLatency(const InputLatency&) = delete;
+	void operator=(const InputLatency&) = delete;
+
+	static InputLatency& getInstance();
+
+	/**
+	 * Returns histogram of the device, creates it if required
+	 * @param name device name
+	 */
+	LatencyHistogramPtr getHistogram(const std::string& name);
+
+	/**
+	 * Logs histograms of all devices
+	 */
+	void dump();
+
+private:
+
+	InputLatency() = default;
+
+	std::mutex mMutex;
+	std::map<std::string, LatencyHistogramPtr> mHistograms;
+};
+
+#endif /* SRC_INPUTLATENCY_HPP_ */
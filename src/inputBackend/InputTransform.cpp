@@ -0,0 +1,91 @@
+/*
+ *  Input coordinate transform
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputTransform.hpp"
+
+/*******************************************************************************
+ * AbsTransform
+ ******************************************************************************/
+
+AbsTransform::AbsTransform() :
+	mIsIdentity(true),
+	mDst(),
+	mMatrix()
+{
+}
+
+AbsTransform::AbsTransform(const InputItf::AbsRange& src,
+						   const InputItf::AbsRange& dst, int rotation) :
+	mIsIdentity(false),
+	mDst(dst),
+	mMatrix()
+{
+	// in normalized coordinates u, v of the device:
+	//   0: X = u,     Y = v
+	//  90: X = 1 - v, Y = u
+	// 180: X = 1 - u, Y = 1 - v
+	// 270: X = v,     Y = 1 - u
+
+	bool isSwapped = rotation == 90 || rotation == 270;
+
+	setRow(mMatrix[0], isSwapped, rotation == 90 || rotation == 180,
+		   dst.minX, dst.maxX,
+		   isSwapped ? src.minY : src.minX, isSwapped ? src.maxY : src.maxX);
+
+	setRow(mMatrix[1], !isSwapped, rotation == 180 || rotation == 270,
+		   dst.minY, dst.maxY,
+		   isSwapped ? src.minX : src.minY, isSwapped ? src.maxX : src.maxY);
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+bool AbsTransform::isRotation(int rotation)
+{
+	return rotation == 0 || rotation == 90 ||
+		   rotation == 180 || rotation == 270;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void AbsTransform::setRow(int64_t* row, bool fromY, bool isInverted,
+						  int32_t dstMin, int32_t dstMax,
+						  int32_t srcMin, int32_t srcMax)
+{
+	int64_t srcRange = static_cast<int64_t>(srcMax) - srcMin;
+	int64_t dstRange = static_cast<int64_t>(dstMax) - dstMin;
+
+	// dst = base + scale * (src - srcMin)
+
+	int64_t scale = srcRange > 0 ?
+					((dstRange << cFracBits) + srcRange / 2) / srcRange : 0;
+	int64_t base = isInverted ? dstMax : dstMin;
+
+	if (isInverted)
+	{
+		scale = -scale;
+	}
+
+	row[fromY ? 1 : 0] = scale;
+	row[2] = (base << cFracBits) - scale * srcMin;
+}
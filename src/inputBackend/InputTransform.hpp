@@ -0,0 +1,98 @@
+/*
+ *  Input coordinate transform
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUTTRANSFORM_HPP_
+#define SRC_INPUTTRANSFORM_HPP_
+
+#include <cstdint>
+
+#include "InputItf.hpp"
+
+/***************************************************************************//**
+ * Transform of absolute pointer and touch positions.
+ * Maps the device range to the frontend range rotating positions clockwise by
+ * 0, 90, 180 or 270 degrees. The affine matrix is computed once in 16.16 fixed
+ * point, so applying it takes two multiplications per axis. Positions out of
+ * the device range are clamped to the frontend range. Default transform
+ * keeps positions as is.
+ * @ingroup input_be
+ ******************************************************************************/
+class AbsTransform
+{
+public:
+
+	AbsTransform();
+
+	/**
+	 * @param src      device range
+	 * @param dst      frontend range
+	 * @param rotation clockwise rotation in degrees: 0, 90, 180 or 270
+	 */
+	AbsTransform(const InputItf::AbsRange& src, const InputItf::AbsRange& dst,
+				 int rotation);
+
+	/**
+	 * Transforms the position
+	 * @param x X coordinate
+	 * @param y Y coordinate
+	 */
+	void apply(int32_t& x, int32_t& y) const
+	{
+		if (mIsIdentity)
+		{
+			return;
+		}
+
+		int32_t srcX = x;
+
+		x = applyRow(mMatrix[0], srcX, y, mDst.minX, mDst.maxX);
+		y = applyRow(mMatrix[1], srcX, y, mDst.minY, mDst.maxY);
+	}
+
+	/**
+	 * Checks if the rotation is supported
+	 * @param rotation rotation in degrees
+	 */
+	static bool isRotation(int rotation);
+
+private:
+
+	static const int cFracBits = 16;
+
+	bool mIsIdentity;
+	InputItf::AbsRange mDst;
+	// rows of X and Y: x coefficient, y coefficient, offset
+	int64_t mMatrix[2][3];
+
+	void setRow(int64_t* row, bool fromY, bool isInverted,
+				int32_t dstMin, int32_t dstMax,
+				int32_t srcMin, int32_t srcMax);
+
+	static int32_t applyRow(const int64_t* row, int32_t x, int32_t y,
+							int32_t min, int32_t max)
+	{
+		int64_t value = (row[0] * x + row[1] * y + row[2] +
+						(1 << (cFracBits - 1))) >> cFracBits;
+
+		return value < min ? min : value > max ? max : value;
+	}
+};
+
+#endif /* SRC_INPUTTRANSFORM_HPP_ */
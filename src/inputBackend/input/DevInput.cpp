@@ -7,10 +7,6 @@
 
 #include <iomanip>
 
-#include <fcntl.h>
-
-#include <xen/be/Exception.hpp>
-
 #include "DevInput.hpp"
 
 using std::lock_guard;
@@ -18,9 +14,6 @@ using std::mutex;
 using std::setfill;
 using std::setw;
 using std::string;
-using std::thread;
-
-using XenBackend::PollFd;
 
 using InputItf::KeyboardCallbacks;
 using InputItf::PointerCallbacks;
@@ -30,118 +23,85 @@ using InputItf::TouchCallbacks;
  * InputBase
  ******************************************************************************/
 
-DevInputBase::DevInputBase(const string& name) :
+DevInputBase::DevInputBase(const string& name, int domId) :
 	mLog("DevInputDevice"),
 	mName(name),
-	mFd(-1)
+	mDomId(domId),
+	mSource(createSource(name)),
+	mLatency(InputLatency::getInstance().getHistogram(name))
 {
-	try
-	{
-		init();
-	}
-	catch(const std::exception& e)
-	{
-		release();
-
-		throw;
-	}
+	LOG(mLog, DEBUG) << "Create: " << mName << ", dom id: " << mDomId;
 }
 
 DevInputBase::~DevInputBase()
 {
 	stop();
-	release();
+
+	LOG(mLog, DEBUG) << "Delete: " << mName;
 }
 
 void DevInputBase::start()
 {
-	if (!mThread.joinable())
-	{
-		mThread = thread(&DevInputBase::run, this);
-	}
+	mSource->addListener(this);
 }
 
 void DevInputBase::stop()
 {
-	if (mPollFd)
-	{
-		mPollFd->stop();
-	}
-
-	if (mThread.joinable())
-	{
-		mThread.join();
-	}
+	mSource->removeListener(this);
 }
 
 /*******************************************************************************
- * Private
+ * Protected
  ******************************************************************************/
 
-void DevInputBase::init()
+void DevInputBase::measureLatency(const input_event& event)
 {
-	mFd = open(mName.c_str(), O_RDONLY);
-
-	if (mFd < 0)
-	{
-		throw XenBackend::Exception("Can't open device: " + mName, errno);
-	}
-
-	if (ioctl(mFd, EVIOCGRAB, reinterpret_cast<void*>(1)))
-	{
-		throw XenBackend::Exception("Grabbed by another process", EBUSY);
-	}
-
-	ioctl(mFd, EVIOCGRAB, reinterpret_cast<void*>(0));
-
-	mPollFd.reset(new PollFd(mFd, POLLIN));
-
-	LOG(mLog, DEBUG) << "Create: " << mName;
+	mLatency->addSince(event.input_event_sec * 1000000ull +
+					   event.input_event_usec);
 }
 
-void DevInputBase::release()
+bool DevInputBase::getAbsInfo(uint16_t code, input_absinfo& info)
 {
-	if (mFd >= 0)
-	{
-		close(mFd);
-
-		LOG(mLog, DEBUG) << "Delete: " << mName;
-	}
+	return mSource->getAbsInfo(code, info);
 }
 
-void DevInputBase::run()
+bool DevInputBase::getAbsRange(uint16_t codeX, uint16_t codeY,
+							   InputItf::AbsRange& range)
 {
-	try
+	input_absinfo infoX = {}, infoY = {};
+
+	// replayed and disconnected devices have no axis info
+
+	if (!getAbsInfo(codeX, infoX) || !getAbsInfo(codeY, infoY) ||
+		infoX.maximum <= infoX.minimum || infoY.maximum <= infoY.minimum)
 	{
-		while(mPollFd->poll())
-		{
-			int readSize = 0;
+		return false;
+	}
 
-			input_event events[64];
+	range = { infoX.minimum, infoX.maximum, infoY.minimum, infoY.maximum };
 
-			readSize = read(mFd, events, sizeof(events));
+	return true;
+}
 
-			if (readSize < static_cast<int>(sizeof(struct input_event)))
-			{
-				throw XenBackend::Exception("Read error", errno);
-			}
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
 
-			for(size_t i = 0; i < readSize/sizeof(input_event); i++)
-			{
-				onEvent(events[i]);
-			}
-		}
-	}
-	catch(const std::exception& e)
+InputSourcePtr DevInputBase::createSource(const string& name)
+{
+	if (InputReplay::isReplay(name))
 	{
-		LOG(mLog, ERROR) << e.what();
+		return InputSourcePtr(new InputReplay(name));
 	}
+
+	return InputReactor::getInstance().getDevice(name);
 }
 
 /*******************************************************************************
  * InputKeyboard
  ******************************************************************************/
-DevInput<KeyboardCallbacks>::DevInput(const string& name) : DevInputCbk(name)
+DevInput<KeyboardCallbacks>::DevInput(const string& name, int domId) :
+	DevInputCbk(name, domId)
 {
 	start();
 }
@@ -162,13 +122,21 @@ void DevInput<KeyboardCallbacks>::onEvent(const input_event& event)
 
 		mCallbacks.key(event.code, event.value);
 	}
+
+	if (event.type == EV_SYN && event.code == SYN_REPORT && mCallbacks.frame)
+	{
+		mCallbacks.frame();
+
+		measureLatency(event);
+	}
 }
 
 /*******************************************************************************
  * InputPointer
  ******************************************************************************/
 
-DevInput<PointerCallbacks>::DevInput(const string& name) : DevInputCbk(name)
+DevInput<PointerCallbacks>::DevInput(const string& name, int domId) :
+	DevInputCbk(name, domId)
 {
 	mRelX = mRelY = mRelZ = mAbsX = mAbsY = 0;
 	mSendRel = mSendAbs = mSendWheel = false;
@@ -206,23 +174,31 @@ void DevInput<PointerCallbacks>::onEvent(const input_event& event)
 	}
 }
 
+bool DevInput<PointerCallbacks>::getAbsRange(InputItf::AbsRange& range)
+{
+	return DevInputBase::getAbsRange(ABS_X, ABS_Y, range);
+}
+
 void DevInput<PointerCallbacks>::onRelEvent(const input_event& event)
 {
+	// the device deltas are forwarded as is, they are summed up if the frame
+	// has several events for the same axis
+
 	if (event.code == REL_X)
 	{
-		mRelX = event.value;
+		mRelX += event.value;
 
 		mSendRel = true;
 	}
 	else if (event.code == REL_Y)
 	{
-		mRelY = event.value;
+		mRelY += event.value;
 
 		mSendRel = true;
 	}
 	else if (event.code == REL_WHEEL)
 	{
-		mRelZ = event.value;
+		mRelZ += event.value;
 
 		mSendWheel = true;
 	}
@@ -270,11 +246,13 @@ void DevInput<PointerCallbacks>::onSynEvent(const input_event& event)
 
 		mCallbacks.moveRelative(mRelX, mRelY, mRelZ);
 
-		mRelX = mRelY = mRelZ = 0;
+		mRelZ = 0;
 		mSendWheel = false;
-		mSendRel = false;
 	}
 
+	mRelX = mRelY = 0;
+	mSendRel = false;
+
 	if (mSendAbs && mCallbacks.moveAbsolute)
 	{
 		LOG(mLog, DEBUG) << mName
@@ -288,20 +266,48 @@ void DevInput<PointerCallbacks>::onSynEvent(const input_event& event)
 		mSendWheel = false;
 		mSendAbs = false;
 	}
+
+	if (event.code == SYN_REPORT && mCallbacks.frame)
+	{
+		mCallbacks.frame();
+
+		measureLatency(event);
+	}
 }
 
 /*******************************************************************************
  * InputTouch
  ******************************************************************************/
 
-DevInput<TouchCallbacks>::DevInput(const string& name) : DevInputCbk(name)
+DevInput<TouchCallbacks>::DevInput(const string& name, int domId) :
+	DevInputCbk(name, domId)
 {
-	mKey = 0;
-	mSendAbs = mSendKey = mMtReport = false;
-	mLastMtReports = 0;
+	input_absinfo info = {};
+	uint32_t capacity = cMaxContacts;
+
+	// devices without slots (type A, single touch or replayed ones) get the
+	// full table
+
+	if (getAbsInfo(ABS_MT_SLOT, info) && info.maximum >= 0 &&
+		static_cast<uint32_t>(info.maximum) < cMaxContacts)
+	{
+		capacity = info.maximum + 1;
+	}
 
-	setCurrentSlot(0);
-	mContacts[mCurrentSlot].id = -1;
+	mContacts.assign(capacity, Contact{});
+	mDirtyContacts = 0;
+	mCurrentSlot = 0;
+	mIsMultiTouch = getAbsInfo(ABS_MT_POSITION_X, info);
+	mMtReport = false;
+	mOrientMax = 0;
+
+	if (getAbsInfo(ABS_MT_ORIENTATION, info) && info.maximum > 0)
+	{
+		mOrientMax = info.maximum;
+	}
+
+	LOG(mLog, DEBUG) << mName << ", contacts: " << capacity
+					 << ", multi touch: " << mIsMultiTouch;
 
 	start();
 }
@@ -332,50 +338,94 @@ void DevInput<TouchCallbacks>::onEvent(const input_event& event)
 	}
 }
 
-void DevInput<TouchCallbacks>::setCurrentSlot(uint32_t slot)
+bool DevInput<TouchCallbacks>::getAbsRange(InputItf::AbsRange& range)
 {
-	if (slot >= mContacts.size())
+	return DevInputBase::getAbsRange(ABS_MT_POSITION_X, ABS_MT_POSITION_Y,
+									 range) ||
+		   DevInputBase::getAbsRange(ABS_X, ABS_Y, range);
+}
+
+void DevInput<TouchCallbacks>::setDirty(uint8_t flags)
+{
+	// slots beyond the table capacity are ignored
+
+	if (mCurrentSlot >= mContacts.size())
 	{
-		mContacts.resize(slot + 1, {-1});
+		return;
 	}
 
-	mCurrentSlot = slot;
+	mContacts[mCurrentSlot].dirty |= flags;
+	mDirtyContacts |= 1ull << mCurrentSlot;
 }
 
 void DevInput<TouchCallbacks>::onAbsEvent(const input_event& event)
 {
+	if (event.code == ABS_MT_SLOT)
+	{
+		mCurrentSlot = event.value;
+
+		return;
+	}
+
+	// single touch axes of multi touch devices emulate a pointer, they are
+	// ignored as contacts are reported by ABS_MT_* axes
+
+	if (event.code > ABS_MT_SLOT)
+	{
+		mIsMultiTouch = true;
+	}
+	else if (mIsMultiTouch)
+	{
+		return;
+	}
+
+	if (mCurrentSlot >= mContacts.size())
+	{
+		return;
+	}
+
+	auto& contact = mContacts[mCurrentSlot];
+
 	switch(event.code)
 	{
 		case ABS_X:
 		case ABS_MT_POSITION_X:
-			mContacts[mCurrentSlot].absX = event.value;
-			mSendAbs = true;
+			contact.absX = event.value;
+			setDirty(cDirtyMotion);
 			break;
 
 		case ABS_Y:
 		case ABS_MT_POSITION_Y:
-			mContacts[mCurrentSlot].absY = event.value;
-			mSendAbs = true;
+			contact.absY = event.value;
+			setDirty(cDirtyMotion);
+			break;
+
+		case ABS_MT_TOUCH_MAJOR:
+			contact.major = event.value;
+			setDirty(cDirtyShape);
 			break;
 
-		case ABS_MT_SLOT:
-			flushEvents();
-			setCurrentSlot(event.value);
+		case ABS_MT_TOUCH_MINOR:
+			contact.minor = event.value;
+			setDirty(cDirtyShape);
+			break;
+
+		case ABS_MT_ORIENTATION:
+			contact.orient = event.value;
+			setDirty(cDirtyOrient);
 			break;
 
 		case ABS_MT_TRACKING_ID:
 			if (event.value >= 0)
 			{
-				mContacts[mCurrentSlot].id = event.value;
-				mKey = 1;
-				mSendKey = true;
+				// the slot may be reused by a new contact within one frame
+
+				setDirty(contact.active ? cDirtyUp | cDirtyDown : cDirtyDown);
 			}
 			else
 			{
-				mKey = 0;
-				mSendKey = true;
-
-				flushEvents();
+				contact.dirty &= ~cDirtyDown;
+				setDirty(cDirtyUp);
 			}
 			break;
 	}
@@ -383,108 +433,174 @@ void DevInput<TouchCallbacks>::onAbsEvent(const input_event& event)
 
 void DevInput<TouchCallbacks>::onKeyEvent(const input_event& event)
 {
-	mKey = event.value;
-	mSendKey = true;
+	// multi touch devices report contacts by tracking id or MT reports
+
+	if (event.code != BTN_TOUCH || mIsMultiTouch ||
+		mCurrentSlot >= mContacts.size())
+	{
+		return;
+	}
+
+	if (event.value)
+	{
+		setDirty(cDirtyDown);
+	}
+	else
+	{
+		mContacts[mCurrentSlot].dirty &= ~cDirtyDown;
+		setDirty(cDirtyUp);
+	}
 }
 
 void DevInput<TouchCallbacks>::onSynEvent(const input_event& event)
 {
 	if (event.code == SYN_MT_REPORT)
 	{
-		int32_t nextSlot = mCurrentSlot;
-
-		if (mSendAbs)
-		{
-			nextSlot = mCurrentSlot + 1;
-		}
-
-		if (mContacts[mCurrentSlot].id == -1)
-		{
-			mKey = 1;
-			mSendKey = true;
-		}
-
-		flushEvents();
-
-		setCurrentSlot(nextSlot);
-
-		mMtReport = true;
+		onMtReport();
 	}
 
 	if (event.code == SYN_REPORT)
 	{
 		if (mMtReport)
 		{
-			for(int32_t i = mCurrentSlot; i < mLastMtReports; i++)
-			{
-				setCurrentSlot(i);
-				mKey = 0;
-				mSendKey = true;
+			// contacts which are not reported in this frame are released
 
-				flushEvents();
+			for (uint32_t i = mCurrentSlot; i < mContacts.size(); i++)
+			{
+				if (mContacts[i].active)
+				{
+					mContacts[i].dirty |= cDirtyUp;
+					mDirtyContacts |= 1ull << i;
+				}
 			}
 
-			mLastMtReports = mCurrentSlot;
-
-			setCurrentSlot(0);
+			mCurrentSlot = 0;
 			mMtReport = false;
 		}
 
 		lock_guard<mutex> lock(mMutex);
 
-		flushEvents();
+		if (!mDirtyContacts)
+		{
+			return;
+		}
+
+		flushContacts();
 
 		if (mCallbacks.frame)
 		{
 			LOG(mLog, DEBUG) << mName << ", frame";
 
 			mCallbacks.frame(mCurrentSlot);
+
+			measureLatency(event);
 		}
 	}
 }
 
-void DevInput<TouchCallbacks>::flushEvents()
+void DevInput<TouchCallbacks>::onMtReport()
 {
-	if (mSendKey)
+	// type A devices report each contact with own SYN_MT_REPORT, the contact
+	// index is the order of the report in the frame
+
+	mIsMultiTouch = true;
+	mMtReport = true;
+
+	if (mCurrentSlot >= mContacts.size() ||
+		!(mContacts[mCurrentSlot].dirty & cDirtyMotion))
 	{
-		if ((mKey == 1) && mCallbacks.down)
-		{
-			LOG(mLog, DEBUG) << mName << ", down"
-							 << ", id: " << mCurrentSlot
-							 << ", abs x: " << mContacts[mCurrentSlot].absX
-							 << ", abs y: " << mContacts[mCurrentSlot].absY;
+		return;
+	}
+
+	if (!mContacts[mCurrentSlot].active)
+	{
+		setDirty(cDirtyDown);
+	}
 
-			mCallbacks.down(mCurrentSlot,
-							mContacts[mCurrentSlot].absX,
-							mContacts[mCurrentSlot].absY);
+	mCurrentSlot++;
+}
 
-			mSendAbs = false;
-		}
+void DevInput<TouchCallbacks>::flushContacts()
+{
+	auto dirtyContacts = mDirtyContacts;
+
+	mDirtyContacts = 0;
+
+	while (dirtyContacts)
+	{
+		uint32_t slot = __builtin_ctzll(dirtyContacts);
+
+		dirtyContacts &= dirtyContacts - 1;
+
+		flushContact(slot);
+	}
+}
+
+void DevInput<TouchCallbacks>::flushContact(uint32_t slot)
+{
+	auto& contact = mContacts[slot];
+	auto dirty = contact.dirty;
+
+	contact.dirty = 0;
 
-		if ((mKey == 0) && mCallbacks.up)
+	if ((dirty & cDirtyUp) && contact.active)
+	{
+		contact.active = false;
+
+		if (mCallbacks.up)
 		{
-			LOG(mLog, DEBUG) << mName << ", up"
-							 << ", id: " << mCurrentSlot;
+			LOG(mLog, DEBUG) << mName << ", up, id: " << slot;
+
+			mCallbacks.up(slot);
+		}
+	}
 
-			mCallbacks.up(mCurrentSlot);
+	if (dirty & cDirtyDown)
+	{
+		contact.active = true;
+
+		if (mCallbacks.down)
+		{
+			LOG(mLog, DEBUG) << mName << ", down, id: " << slot
+							 << ", abs x: " << contact.absX
+							 << ", abs y: " << contact.absY;
 
-			mContacts[mCurrentSlot].id = -1;
+			mCallbacks.down(slot, contact.absX, contact.absY);
 		}
+	}
+	else if ((dirty & cDirtyMotion) && contact.active && mCallbacks.motion)
+	{
+		LOG(mLog, DEBUG) << mName << ", motion, id: " << slot
+						 << ", abs x: " << contact.absX
+						 << ", abs y: " << contact.absY;
 
-		mSendKey = false;
+		mCallbacks.motion(slot, contact.absX, contact.absY);
 	}
 
-	if (mSendAbs && mCallbacks.motion)
+	if (!contact.active)
 	{
-		LOG(mLog, DEBUG) << mName << ", motion"
-						 << ", id: " << mCurrentSlot
-						 << ", abs x: " << mContacts[mCurrentSlot].absX
-						 << ", abs y: " << mContacts[mCurrentSlot].absY;
+		return;
+	}
 
-		mSendAbs = false;
+	if ((dirty & cDirtyShape) && mCallbacks.shape)
+	{
+		LOG(mLog, DEBUG) << mName << ", shape, id: " << slot
+						 << ", major: " << contact.major
+						 << ", minor: " << contact.minor;
+
+		mCallbacks.shape(slot, contact.major, contact.minor);
+	}
+
+	if ((dirty & cDirtyOrient) && mCallbacks.orientation)
+	{
+		// evdev max orientation is a quarter turn clockwise
+
+		int32_t degrees = mOrientMax ?
+						  contact.orient * 90 / mOrientMax : contact.orient;
+
+		LOG(mLog, DEBUG) << mName << ", orientation, id: " << slot
+						 << ", degrees: " << degrees;
 
-		mCallbacks.motion(mCurrentSlot,
-						  mContacts[mCurrentSlot].absX,
-						  mContacts[mCurrentSlot].absY);
+		mCallbacks.orientation(slot, degrees);
 	}
 }
@@ -8,15 +8,17 @@
 #ifndef SRC_INPUT_DEVINPUT_HPP_
 #define SRC_INPUT_DEVINPUT_HPP_
 
+#include <mutex>
 #include <string>
-#include <thread>
+#include <vector>
 
 #include <linux/input.h>
 
 #include <xen/be/Log.hpp>
-#include <xen/be/Utils.hpp>
 
 #include "InputItf.hpp"
+#include "InputLatency.hpp"
+#include "InputReactor.hpp"
 
 // TODO: should be reimplemented to use libinput
 
@@ -24,7 +26,11 @@ class DevInputBase
 {
 public:
 
-	DevInputBase(const std::string& name);
+	/**
+	 * @param name  device name
+	 * @param domId frontend domain id
+	 */
+	DevInputBase(const std::string& name, int domId);
 	virtual ~DevInputBase();
 
 	void start();
@@ -37,20 +43,40 @@ protected:
 
 	virtual void onEvent(const input_event& event) = 0;
 
-private:
-
-	const int cPoolEventTimeoutMs = 100;
+	/**
+	 * Measures latency from the event timestamp till now. Shall be called
+	 * after the frame callback.
+	 * @param event event which ends the frame
+	 */
+	void measureLatency(const input_event& event);
+
+	/**
+	 * Gets absolute axis info from the device
+	 * @param code axis code
+	 * @param info axis info
+	 * @return false if the device has no info for the axis
+	 */
+	bool getAbsInfo(uint16_t code, input_absinfo& info);
+
+	/**
+	 * Gets range of the absolute axes
+	 * @param codeX X axis code
+	 * @param codeY Y axis code
+	 * @param range range
+	 * @return false if the device has no info for the axes
+	 */
+	bool getAbsRange(uint16_t codeX, uint16_t codeY,
+					 InputItf::AbsRange& range);
 
-	int mFd;
-
-	std::thread mThread;
+private:
 
-	std::unique_ptr<XenBackend::PollFd> mPollFd;
+	friend class InputSource;
 
-	void init();
-	void release();
+	int mDomId;
+	InputSourcePtr mSource;
+	LatencyHistogramPtr mLatency;
 
-	void run();
+	static InputSourcePtr createSource(const std::string& name);
 };
 
 template <typename T>
@@ -58,7 +84,8 @@ class DevInputCbk : public DevInputBase, public InputItf::InputDevice<T>
 {
 public:
 
-	DevInputCbk(const std::string& name) : DevInputBase(name) {}
+	DevInputCbk(const std::string& name, int domId) :
+		DevInputBase(name, domId) {}
 
 	void setCallbacks(const T& callbacks) override
 	{
@@ -90,7 +117,7 @@ class DevInput<InputItf::KeyboardCallbacks> :
 {
 public:
 
-	DevInput(const std::string& name);
+	DevInput(const std::string& name, int domId);
 	~DevInput();
 
 	void onEvent(const input_event& event) override;
@@ -102,11 +129,13 @@ class DevInput<InputItf::PointerCallbacks> :
 {
 public:
 
-	DevInput(const std::string& name);
+	DevInput(const std::string& name, int domId);
 	~DevInput();
 
 	void onEvent(const input_event& event) override;
 
+	bool getAbsRange(InputItf::AbsRange& range) override;
+
 private:
 
 	int32_t mRelX, mRelY, mRelZ, mAbsX, mAbsY;
@@ -118,39 +147,66 @@ private:
 	void onSynEvent(const input_event& event);
 };
 
+/***************************************************************************//**
+ * Evdev touch device.
+ * Contacts are kept in a table which capacity is taken from ABS_MT_SLOT range
+ * and not changed afterwards. Events only mark changed contacts dirty, on
+ * SYN_REPORT down, up, motion, shape and orientation are emitted for dirty
+ * contacts only. Both slotted (type B) and SYN_MT_REPORT (type A) devices as
+ * well as single touch devices are supported.
+ * @ingroup input_be
+ ******************************************************************************/
 template<>
 class DevInput<InputItf::TouchCallbacks>:
 	public DevInputCbk<InputItf::TouchCallbacks>
 {
 public:
 
-	DevInput(const std::string& name);
+	DevInput(const std::string& name, int domId);
 	~DevInput();
 
 	void onEvent(const input_event& event) override;
 
+	bool getAbsRange(InputItf::AbsRange& range) override;
+
 private:
 
+	// the dirty contacts are tracked by uint64_t mask
+	static const uint32_t cMaxContacts = 64;
+
+	static const uint8_t cDirtyDown = 0x01;
+	static const uint8_t cDirtyUp = 0x02;
+	static const uint8_t cDirtyMotion = 0x04;
+	static const uint8_t cDirtyShape = 0x08;
+	static const uint8_t cDirtyOrient = 0x10;
+
 	struct Contact
 	{
-		int32_t id;
 		int32_t absX;
 		int32_t absY;
+		int32_t major;
+		int32_t minor;
+		int32_t orient;
+		bool active;
+		uint8_t dirty;
 	};
 
-	int32_t mKey;
-	bool mSendAbs, mSendKey;
-	bool mMtReport;
-	int32_t mLastMtReports;
+	std::vector<Contact> mContacts;
+	uint64_t mDirtyContacts;
 
 	uint32_t mCurrentSlot;
-	std::vector<Contact> mContacts;
+	bool mIsMultiTouch;
+	bool mMtReport;
+
+	int32_t mOrientMax;
 
-	void setCurrentSlot(uint32_t slot);
+	void setDirty(uint8_t flags);
 	void onAbsEvent(const input_event& event);
 	void onKeyEvent(const input_event& event);
 	void onSynEvent(const input_event& event);
-	void flushEvents();
+	void onMtReport();
+	void flushContacts();
+	void flushContact(uint32_t slot);
 };
 
 #endif /* SRC_INPUT_DEVINPUT_HPP_ */
@@ -0,0 +1,108 @@
+/*
+ *  Input focus
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputFocus.hpp"
+
+using std::lock_guard;
+using std::mutex;
+
+/*******************************************************************************
+ * InputFocus
+ ******************************************************************************/
+
+InputFocus::InputFocus() :
+	mFocus(cNoFocus),
+	mLog("InputFocus")
+{
+}
+
+InputFocus& InputFocus::getInstance()
+{
+	static InputFocus sInputFocus;
+
+	return sInputFocus;
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void InputFocus::addDomain(int domId)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	mDomains[domId]++;
+
+	if (mFocus == cNoFocus)
+	{
+		mFocus = domId;
+
+		LOG(mLog, DEBUG) << "Focus dom id: " << mFocus;
+	}
+}
+
+void InputFocus::removeDomain(int domId)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto it = mDomains.find(domId);
+
+	if (it == mDomains.end() || --it->second)
+	{
+		return;
+	}
+
+	it = mDomains.erase(it);
+
+	if (mFocus != domId)
+	{
+		return;
+	}
+
+	if (it == mDomains.end())
+	{
+		it = mDomains.begin();
+	}
+
+	mFocus = it == mDomains.end() ? cNoFocus : it->first;
+
+	LOG(mLog, DEBUG) << "Focus dom id: " << mFocus;
+}
+
+void InputFocus::switchNext()
+{
+	lock_guard<mutex> lock(mMutex);
+
+	if (mDomains.empty())
+	{
+		return;
+	}
+
+	auto it = mDomains.upper_bound(mFocus);
+
+	if (it == mDomains.end())
+	{
+		it = mDomains.begin();
+	}
+
+	mFocus = it->first;
+
+	LOG(mLog, INFO) << "Focus dom id: " << mFocus;
+}
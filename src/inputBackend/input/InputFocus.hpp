@@ -0,0 +1,82 @@
+/*
+ *  Input focus
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUT_INPUTFOCUS_HPP_
+#define SRC_INPUT_INPUTFOCUS_HPP_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#include <xen/be/Log.hpp>
+
+/***************************************************************************//**
+ * Input focus across frontend domains.
+ * Devices shared by several domains deliver events to the focused domain
+ * only. The focus is moved to the next domain by switchNext(). If the focused
+ * domain has no devices anymore, the focus moves to the next one.
+ * @ingroup input_be
+ ******************************************************************************/
+class InputFocus
+{
+public:
+
+	static const int cNoFocus = -1;
+
+	InputFocus(const InputFocus&) = delete;
+	void operator=(const InputFocus&) = delete;
+
+	static InputFocus& getInstance();
+
+	/**
+	 * Adds device of the domain
+	 * @param domId domain id
+	 */
+	void addDomain(int domId);
+
+	/**
+	 * Removes device of the domain
+	 * @param domId domain id
+	 */
+	void removeDomain(int domId);
+
+	/**
+	 * Returns focused domain id or cNoFocus
+	 */
+	int getFocus() const { return mFocus; }
+
+	/**
+	 * Moves the focus to the next domain
+	 */
+	void switchNext();
+
+private:
+
+	InputFocus();
+
+	std::atomic<int> mFocus;
+	XenBackend::Log mLog;
+
+	std::mutex mMutex;
+	// domain id -> number of devices
+	std::map<int, uint32_t> mDomains;
+};
+
+#endif /* SRC_INPUT_INPUTFOCUS_HPP_ */
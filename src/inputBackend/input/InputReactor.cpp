@@ -0,0 +1,772 @@
+/*
+ *  Evdev input reactor
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputReactor.hpp"
+
+#include <ctime>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <xen/be/Exception.hpp>
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::thread;
+using std::vector;
+using std::weak_ptr;
+
+/*******************************************************************************
+ * EvdevDevice
+ ******************************************************************************/
+
+string EvdevDevice::sRecordDir;
+
+EvdevDevice::EvdevDevice(const string& name) :
+	InputSource(name),
+	mFd(-1),
+	mHasInputId(false),
+	mActiveSlots(0),
+	mCurrentSlot(0)
+{
+	try
+	{
+		init();
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+EvdevDevice::~EvdevDevice()
+{
+	InputReactor::getInstance().removeDevice(mFd);
+
+	release();
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+bool EvdevDevice::getAbsInfo(uint16_t code, input_absinfo& info)
+{
+	lock_guard<mutex> lock(mFdMutex);
+
+	return mFd >= 0 && ioctl(mFd, EVIOCGABS(code), &info) == 0;
+}
+
+void EvdevDevice::setRecordDir(const string& dir)
+{
+	sRecordDir = dir;
+}
+
+bool EvdevDevice::isUdevId(const string& name)
+{
+	return name.compare(0, string(cUdevIdPrefix).length(),
+						cUdevIdPrefix) == 0;
+}
+
+/*******************************************************************************
+ * Protected
+ ******************************************************************************/
+
+void EvdevDevice::getReleaseEvents(vector<input_event>& events)
+{
+	createReleaseEvents(events, mCurrentSlot);
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void EvdevDevice::init()
+{
+	if (!sRecordDir.empty())
+	{
+		auto pos = mName.find_last_of('/');
+
+		mRecorder.reset(new InputRecorder(sRecordDir + "/" +
+										  mName.substr(pos + 1) + ".rec"));
+	}
+
+	// the device which is not plugged yet is opened on hotplug
+
+	if (!open(getDevNode()))
+	{
+		LOG(mLog, WARNING) << "Device is not connected: " << mName;
+
+		if (!canReconnect())
+		{
+			LOG(mLog, WARNING) << "Device won't be connected on hotplug, "
+							   << "use by-id link or udev ids: " << mName;
+		}
+	}
+
+	LOG(mLog, DEBUG) << "Create: " << mName << ", fd: " << mFd;
+}
+
+void EvdevDevice::release()
+{
+	if (mFd >= 0)
+	{
+		::close(mFd);
+
+		LOG(mLog, DEBUG) << "Delete: " << mName << ", fd: " << mFd;
+	}
+}
+
+string EvdevDevice::getDevNode()
+{
+	if (!isUdevId(mName))
+	{
+		return mName;
+	}
+
+	// id:<vendor>:<product>
+
+	auto ids = mName.substr(string(cUdevIdPrefix).length());
+	auto pos = ids.find(':');
+
+	if (pos == string::npos)
+	{
+		throw XenBackend::Exception("Invalid udev ids: " + mName, EINVAL);
+	}
+
+	return UdevMonitor::findDevice(ids.substr(0, pos), ids.substr(pos + 1));
+}
+
+bool EvdevDevice::canReconnect() const
+{
+	// the node of the device which has never been opened can't be told from
+	// the node of another device
+
+	return mHasInputId || mName.compare(0, string(cEventNodePrefix).length(),
+										cEventNodePrefix) != 0;
+}
+
+bool EvdevDevice::open(const string& devNode)
+{
+	if (devNode.empty())
+	{
+		return false;
+	}
+
+	int fd = ::open(devNode.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		if (errno == ENOENT || errno == ENODEV)
+		{
+			return false;
+		}
+
+		throw XenBackend::Exception("Can't open device: " + mName, errno);
+	}
+
+	if (ioctl(fd, EVIOCGRAB, reinterpret_cast<void*>(1)))
+	{
+		::close(fd);
+
+		throw XenBackend::Exception("Grabbed by another process", EBUSY);
+	}
+
+	ioctl(fd, EVIOCGRAB, reinterpret_cast<void*>(0));
+
+	// eventN nodes are renumbered on hotplug, so another device may get the
+	// node of the disconnected one
+
+	input_id inputId = {};
+
+	ioctl(fd, EVIOCGID, &inputId);
+
+	if (mHasInputId && (inputId.vendor != mInputId.vendor ||
+						inputId.product != mInputId.product))
+	{
+		::close(fd);
+
+		return false;
+	}
+
+	mInputId = inputId;
+	mHasInputId = true;
+
+	// event timestamps are compared with CLOCK_MONOTONIC to measure latency
+
+	int clockId = CLOCK_MONOTONIC;
+
+	if (ioctl(fd, EVIOCSCLOCKID, &clockId))
+	{
+		LOG(mLog, WARNING) << "Can't set monotonic clock: " << mName
+						   << ", err: " << errno;
+	}
+
+	lock_guard<mutex> lock(mFdMutex);
+
+	mFd = fd;
+
+	LOG(mLog, DEBUG) << "Open: " << mName << ", node: " << devNode
+					 << ", fd: " << mFd;
+
+	return true;
+}
+
+void EvdevDevice::close()
+{
+	releaseState();
+
+	lock_guard<mutex> lock(mFdMutex);
+
+	if (mFd >= 0)
+	{
+		::close(mFd);
+
+		LOG(mLog, DEBUG) << "Close: " << mName << ", fd: " << mFd;
+
+		mFd = -1;
+	}
+}
+
+bool EvdevDevice::read()
+{
+	input_event events[cReadEvents];
+
+	auto readSize = ::read(mFd, events, sizeof(events));
+
+	if (readSize < 0 && (errno == EAGAIN || errno == EINTR))
+	{
+		return true;
+	}
+
+	if (readSize < static_cast<ssize_t>(sizeof(input_event)))
+	{
+		LOG(mLog, ERROR) << "Read error: " << mName << ", err: " << errno;
+
+		return false;
+	}
+
+	auto count = readSize / sizeof(input_event);
+
+	if (mRecorder)
+	{
+		mRecorder->write(events, count);
+	}
+
+	// the state before the events is released if the focus is switched
+
+	dispatch(events, count);
+
+	updateState(events, count);
+
+	return true;
+}
+
+void EvdevDevice::updateState(const input_event* events, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		auto& event = events[i];
+
+		// value 2 is autorepeat, the key stays pressed
+
+		if (event.type == EV_KEY && event.code < KEY_CNT && event.value != 2)
+		{
+			mPressedKeys[event.code] = event.value;
+		}
+
+		if (event.type == EV_ABS && event.code == ABS_MT_SLOT)
+		{
+			mCurrentSlot = event.value;
+		}
+
+		if (event.type == EV_ABS && event.code == ABS_MT_TRACKING_ID &&
+			mCurrentSlot >= 0 && mCurrentSlot < cMaxSlots)
+		{
+			if (event.value >= 0)
+			{
+				mActiveSlots |= 1ull << mCurrentSlot;
+			}
+			else
+			{
+				mActiveSlots &= ~(1ull << mCurrentSlot);
+			}
+		}
+	}
+}
+
+void EvdevDevice::createReleaseEvents(vector<input_event>& events,
+									  int32_t nextSlot)
+{
+	if (mPressedKeys.none() && !mActiveSlots)
+	{
+		return;
+	}
+
+	timespec ts = {};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	auto add = [&events, &ts](uint16_t type, uint16_t code, int32_t value)
+	{
+		input_event event = {};
+
+		event.input_event_sec = ts.tv_sec;
+		event.input_event_usec = ts.tv_nsec / 1000;
+		event.type = type;
+		event.code = code;
+		event.value = value;
+
+		events.push_back(event);
+	};
+
+	for (uint16_t code = 0; code < KEY_CNT; code++)
+	{
+		if (mPressedKeys[code])
+		{
+			add(EV_KEY, code, 0);
+		}
+	}
+
+	for (int slot = 0; slot < cMaxSlots; slot++)
+	{
+		if (mActiveSlots & (1ull << slot))
+		{
+			add(EV_ABS, ABS_MT_SLOT, slot);
+			add(EV_ABS, ABS_MT_TRACKING_ID, -1);
+		}
+	}
+
+	// the device doesn't repeat the slot of following events
+
+	if (mActiveSlots)
+	{
+		add(EV_ABS, ABS_MT_SLOT, nextSlot);
+	}
+
+	add(EV_SYN, SYN_REPORT, 0);
+}
+
+void EvdevDevice::releaseState()
+{
+	// the guest would see pressed keys and touches till the device is
+	// plugged again, so they are released as the device would do
+
+	vector<input_event> events;
+
+	createReleaseEvents(events, 0);
+
+	if (events.empty())
+	{
+		return;
+	}
+
+	LOG(mLog, DEBUG) << "Release state: " << mName
+					 << ", events: " << events.size();
+
+	mPressedKeys.reset();
+	mActiveSlots = 0;
+	mCurrentSlot = 0;
+
+	if (mRecorder)
+	{
+		mRecorder->write(events.data(), events.size());
+	}
+
+	dispatch(events.data(), events.size());
+}
+
+/*******************************************************************************
+ * InputReactor
+ ******************************************************************************/
+
+InputReactor::InputReactor() :
+	mEpollFd(-1),
+	mEventFd(-1),
+	mLog("InputReactor")
+{
+	try
+	{
+		init();
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+InputReactor::~InputReactor()
+{
+	uint64_t value = 1;
+
+	if (write(mEventFd, &value, sizeof(value)) < 0)
+	{
+		LOG(mLog, ERROR) << "Can't stop reactor, err: " << errno;
+	}
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+
+	release();
+}
+
+InputReactor& InputReactor::getInstance()
+{
+	static InputReactor sInputReactor;
+
+	return sInputReactor;
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+EvdevDevicePtr InputReactor::getDevice(const string& name)
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		auto device = findDevice(name);
+
+		if (device)
+		{
+			return device;
+		}
+	}
+
+	// the device is opened out of the lock as its release removes it from
+	// the reactor
+
+	return addDevice(EvdevDevicePtr(new EvdevDevice(name)));
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void InputReactor::init()
+{
+	mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (mEpollFd < 0)
+	{
+		throw XenBackend::Exception("Can't create epoll", errno);
+	}
+
+	mEventFd = eventfd(0, EFD_CLOEXEC);
+
+	if (mEventFd < 0)
+	{
+		throw XenBackend::Exception("Can't create eventfd", errno);
+	}
+
+	epoll_event event = {};
+
+	event.events = EPOLLIN;
+	event.data.fd = mEventFd;
+
+	if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &event) < 0)
+	{
+		throw XenBackend::Exception("Can't add eventfd to epoll", errno);
+	}
+
+	// devices are not reconnected without udev, but they still work
+
+	try
+	{
+		mUdevMonitor.reset(new UdevMonitor());
+
+		event.events = EPOLLIN;
+		event.data.fd = mUdevMonitor->getFd();
+
+		if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mUdevMonitor->getFd(),
+					  &event) < 0)
+		{
+			throw XenBackend::Exception("Can't add udev monitor to epoll",
+										errno);
+		}
+	}
+	catch(const std::exception& e)
+	{
+		LOG(mLog, WARNING) << "Hotplug is disabled: " << e.what();
+
+		mUdevMonitor.reset();
+	}
+
+	mThread = thread(&InputReactor::run, this);
+
+	LOG(mLog, DEBUG) << "Create";
+}
+
+void InputReactor::release()
+{
+	mUdevMonitor.reset();
+
+	if (mEventFd >= 0)
+	{
+		close(mEventFd);
+	}
+
+	if (mEpollFd >= 0)
+	{
+		close(mEpollFd);
+	}
+}
+
+EvdevDevicePtr InputReactor::addDevice(EvdevDevicePtr device)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	// the same device could be added while this one is being opened
+
+	auto existing = findDevice(device->getName());
+
+	if (existing)
+	{
+		return existing;
+	}
+
+	if (device->getFd() >= 0)
+	{
+		addToEpoll(device);
+	}
+	else
+	{
+		mDisconnectedDevices.push_back(device);
+	}
+
+	LOG(mLog, DEBUG) << "Add device: " << device->getName()
+					 << ", devices: " << mDevices.size()
+					 << ", disconnected: " << mDisconnectedDevices.size();
+
+	return device;
+}
+
+void InputReactor::removeDevice(int fd)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	// the device may be already removed from epoll on read error
+
+	if (fd >= 0)
+	{
+		epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+		mDevices.erase(fd);
+	}
+
+	mDisconnectedDevices.remove_if([](const weak_ptr<EvdevDevice>& device)
+								   { return device.expired(); });
+
+	LOG(mLog, DEBUG) << "Remove device, fd: " << fd
+					 << ", devices: " << mDevices.size()
+					 << ", disconnected: " << mDisconnectedDevices.size();
+}
+
+void InputReactor::addToEpoll(EvdevDevicePtr device)
+{
+	epoll_event event = {};
+
+	event.events = EPOLLIN;
+	event.data.fd = device->getFd();
+
+	if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, device->getFd(), &event) < 0)
+	{
+		throw XenBackend::Exception("Can't add device to epoll: " +
+									device->getName(), errno);
+	}
+
+	mDevices[device->getFd()] = device;
+}
+
+EvdevDevicePtr InputReactor::findDevice(int fd)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto it = mDevices.find(fd);
+
+	if (it == mDevices.end())
+	{
+		return nullptr;
+	}
+
+	return it->second.lock();
+}
+
+EvdevDevicePtr InputReactor::findDevice(const string& name)
+{
+	for (auto& item : mDevices)
+	{
+		auto device = item.second.lock();
+
+		if (device && device->getName() == name)
+		{
+			DLOG(mLog, DEBUG) << "Share device: " << name;
+
+			return device;
+		}
+	}
+
+	for (auto& item : mDisconnectedDevices)
+	{
+		auto device = item.lock();
+
+		if (device && device->getName() == name)
+		{
+			DLOG(mLog, DEBUG) << "Share disconnected device: " << name;
+
+			return device;
+		}
+	}
+
+	return nullptr;
+}
+
+void InputReactor::disconnectDevice(EvdevDevicePtr device)
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		epoll_ctl(mEpollFd, EPOLL_CTL_DEL, device->getFd(), nullptr);
+
+		mDevices.erase(device->getFd());
+		mDisconnectedDevices.push_back(device);
+	}
+
+	LOG(mLog, WARNING) << "Device disconnected: " << device->getName();
+
+	// dispatches releases, so it is done out of the lock
+
+	device->close();
+}
+
+void InputReactor::connectDevices()
+{
+	vector<EvdevDevicePtr> devices;
+
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		for (auto& item : mDisconnectedDevices)
+		{
+			auto device = item.lock();
+
+			if (device)
+			{
+				devices.push_back(device);
+			}
+		}
+	}
+
+	// the added node is not compared with the device name as the name may be
+	// a link or udev ids, so all disconnected devices are tried
+
+	for (auto& device : devices)
+	{
+		try
+		{
+			if (!device->canReconnect() ||
+				!device->open(device->getDevNode()))
+			{
+				continue;
+			}
+
+			lock_guard<mutex> lock(mMutex);
+
+			addToEpoll(device);
+
+			mDisconnectedDevices.remove_if(
+					[&device](const weak_ptr<EvdevDevice>& item)
+					{ return item.lock() == device; });
+
+			LOG(mLog, INFO) << "Device reconnected: " << device->getName();
+		}
+		catch(const std::exception& e)
+		{
+			LOG(mLog, ERROR) << "Can't reconnect device: "
+							 << device->getName() << ", " << e.what();
+
+			device->close();
+		}
+	}
+}
+
+void InputReactor::run()
+{
+	epoll_event events[cMaxEpollEvents];
+
+	while(true)
+	{
+		auto count = epoll_wait(mEpollFd, events, cMaxEpollEvents, -1);
+
+		if (count < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			LOG(mLog, ERROR) << "Epoll error: " << errno;
+
+			return;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			if (events[i].data.fd == mEventFd)
+			{
+				return;
+			}
+
+			if (mUdevMonitor && events[i].data.fd == mUdevMonitor->getFd())
+			{
+				string devNode;
+
+				if (mUdevMonitor->readAdded(devNode))
+				{
+					connectDevices();
+				}
+
+				continue;
+			}
+
+			// the device is referenced while dispatching, so it can't be
+			// closed by its users meanwhile
+
+			auto device = findDevice(events[i].data.fd);
+
+			if (device && !device->read())
+			{
+				disconnectDevice(device);
+			}
+		}
+	}
+}
@@ -0,0 +1,195 @@
+/*
+ *  Evdev input reactor
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUT_INPUTREACTOR_HPP_
+#define SRC_INPUT_INPUTREACTOR_HPP_
+
+#include <bitset>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <xen/be/Log.hpp>
+
+#include "InputRecord.hpp"
+#include "InputSource.hpp"
+#include "UdevMonitor.hpp"
+
+/***************************************************************************//**
+ * Evdev device handle.
+ * Owns the device fd which is shared by all DevInputBase instances opened with
+ * the same name. Events read from the device are dispatched to all of them.
+ * The name is either a device path, which may be a stable /dev/input/by-id or
+ * /dev/input/by-path link, or id:<vendor>:<product> udev ids. If the device
+ * is unplugged, pressed keys and touch contacts are released and the handle
+ * stays disconnected till the device is plugged again. As eventN nodes are
+ * renumbered on hotplug, a plain /dev/input/eventN device which is not
+ * connected on create is never connected later: use a stable link or udev
+ * ids for such devices.
+ * If the record directory is set, read events are also recorded to
+ * <directory>/<device name>.rec.
+ * @ingroup input_be
+ ******************************************************************************/
+class EvdevDevice : public InputSource
+{
+public:
+
+	/**
+	 * @param name device name
+	 */
+	EvdevDevice(const std::string& name);
+	~EvdevDevice();
+
+	/**
+	 * Returns device fd, -1 if disconnected
+	 */
+	int getFd() const { return mFd; }
+
+	bool getAbsInfo(uint16_t code, input_absinfo& info) override;
+
+	/**
+	 * Sets the directory to record devices opened afterwards
+	 * @param dir record directory
+	 */
+	static void setRecordDir(const std::string& dir);
+
+	/**
+	 * Checks if the name is udev ids
+	 * @param name device name
+	 */
+	static bool isUdevId(const std::string& name);
+
+protected:
+
+	void getReleaseEvents(std::vector<input_event>& events) override;
+
+private:
+
+	friend class InputReactor;
+
+	constexpr static const char* cUdevIdPrefix = "id:";
+	constexpr static const char* cEventNodePrefix = "/dev/input/event";
+
+	static const int cReadEvents = 64;
+	// touch slots tracked to be released on disconnect
+	static const int cMaxSlots = 64;
+
+	static std::string sRecordDir;
+
+	int mFd;
+	bool mHasInputId;
+	input_id mInputId;
+
+	std::mutex mFdMutex;
+
+	std::unique_ptr<InputRecorder> mRecorder;
+
+	std::bitset<KEY_CNT> mPressedKeys;
+	uint64_t mActiveSlots;
+	int32_t mCurrentSlot;
+
+	void init();
+	void release();
+
+	std::string getDevNode();
+	bool canReconnect() const;
+	bool open(const std::string& devNode);
+	void close();
+
+	bool read();
+
+	void updateState(const input_event* events, size_t count);
+	void createReleaseEvents(std::vector<input_event>& events,
+							 int32_t nextSlot);
+	void releaseState();
+};
+
+typedef std::shared_ptr<EvdevDevice> EvdevDevicePtr;
+
+/***************************************************************************//**
+ * Reads all evdev devices from one thread.
+ * Devices fds are waited with epoll, so the number of threads doesn't depend
+ * on the number of devices and guests. The same name is opened once: all
+ * users of the name get the same EvdevDevice.
+ * Udev add events are waited in the same epoll. When a device is added, the
+ * disconnected devices are opened again, their users keep the same
+ * EvdevDevice, so frontend rings are not affected by the reconnection.
+ * @ingroup input_be
+ ******************************************************************************/
+class InputReactor
+{
+public:
+
+	InputReactor(const InputReactor&) = delete;
+	void operator=(const InputReactor&) = delete;
+
+	static InputReactor& getInstance();
+
+	/**
+	 * Returns device handle for the name, opens the device if required
+	 * @param name device name
+	 */
+	EvdevDevicePtr getDevice(const std::string& name);
+
+private:
+
+	friend class EvdevDevice;
+
+	const int cMaxEpollEvents = 16;
+
+	InputReactor();
+	~InputReactor();
+
+	int mEpollFd;
+	int mEventFd;
+
+	XenBackend::Log mLog;
+
+	std::unique_ptr<UdevMonitor> mUdevMonitor;
+
+	std::mutex mMutex;
+	std::thread mThread;
+
+	// fd -> connected device
+	std::unordered_map<int, std::weak_ptr<EvdevDevice>> mDevices;
+	std::list<std::weak_ptr<EvdevDevice>> mDisconnectedDevices;
+
+	void init();
+	void release();
+
+	EvdevDevicePtr addDevice(EvdevDevicePtr device);
+	void removeDevice(int fd);
+
+	void addToEpoll(EvdevDevicePtr device);
+
+	EvdevDevicePtr findDevice(int fd);
+	// should be called under mMutex
+	EvdevDevicePtr findDevice(const std::string& name);
+
+	void disconnectDevice(EvdevDevicePtr device);
+	void connectDevices();
+
+	void run();
+};
+
+#endif /* SRC_INPUT_INPUTREACTOR_HPP_ */
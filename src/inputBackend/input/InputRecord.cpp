@@ -0,0 +1,251 @@
+/*
+ *  Input record and replay
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputRecord.hpp"
+
+#include <chrono>
+
+#include <xen/be/Exception.hpp>
+
+#include "DevInput.hpp"
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+using std::ios;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::thread;
+using std::unique_lock;
+
+static_assert(sizeof(InputRecordEvent) == 16, "Wrong record event size");
+
+/*******************************************************************************
+ * InputRecorder
+ ******************************************************************************/
+
+InputRecorder::InputRecorder(const string& fileName) :
+	mFileName(fileName),
+	mCount(0),
+	mLog("InputRecorder")
+{
+	mFile.open(mFileName, ios::binary | ios::trunc);
+
+	if (!mFile)
+	{
+		throw XenBackend::Exception("Can't create record file: " + mFileName,
+									errno);
+	}
+
+	InputRecordHeader header = {InputRecordHeader::cMagic,
+								InputRecordHeader::cVersion};
+
+	mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	LOG(mLog, DEBUG) << "Create: " << mFileName;
+}
+
+InputRecorder::~InputRecorder()
+{
+	LOG(mLog, DEBUG) << "Delete: " << mFileName << ", events: " << mCount;
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void InputRecorder::write(const input_event* events, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		InputRecordEvent record = {
+			events[i].input_event_sec * 1000000ull + events[i].input_event_usec,
+			events[i].type,
+			events[i].code,
+			events[i].value
+		};
+
+		mFile.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+
+	mFile.flush();
+
+	if (!mFile)
+	{
+		LOG(mLog, ERROR) << "Can't write record file: " << mFileName;
+
+		mFile.clear();
+	}
+
+	mCount += count;
+}
+
+/*******************************************************************************
+ * InputReplay
+ ******************************************************************************/
+
+InputReplay::InputReplay(const string& name) :
+	InputSource(name),
+	mFast(name.compare(0, string(cFastPrefix).length(), cFastPrefix) == 0),
+	mTerminate(false)
+{
+	auto fileName = name.substr(name.find(':') + 1);
+
+	mFile.open(fileName, ios::binary);
+
+	if (!mFile)
+	{
+		throw XenBackend::Exception("Can't open record file: " + fileName,
+									errno);
+	}
+
+	InputRecordHeader header = {};
+
+	mFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	if (!mFile || header.magic != InputRecordHeader::cMagic ||
+		header.version != InputRecordHeader::cVersion)
+	{
+		throw XenBackend::Exception("Wrong record file: " + fileName, EINVAL);
+	}
+
+	LOG(mLog, DEBUG) << "Create replay: " << fileName << ", fast: " << mFast;
+}
+
+InputReplay::~InputReplay()
+{
+	{
+		lock_guard<mutex> lock(mMutex);
+
+		mTerminate = true;
+
+		mCondVar.notify_one();
+	}
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void InputReplay::addListener(DevInputBase* listener)
+{
+	InputSource::addListener(listener);
+
+	lock_guard<mutex> lock(mMutex);
+
+	if (!mThread.joinable())
+	{
+		mThread = thread(&InputReplay::run, this);
+	}
+}
+
+bool InputReplay::isReplay(const string& name)
+{
+	return name.compare(0, string(cPrefix).length(), cPrefix) == 0 ||
+		   name.compare(0, string(cFastPrefix).length(), cFastPrefix) == 0;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void InputReplay::run()
+{
+	try
+	{
+		replay();
+	}
+	catch(const std::exception& e)
+	{
+		LOG(mLog, ERROR) << e.what();
+	}
+}
+
+void InputReplay::replay()
+{
+	input_event events[cDispatchEvents];
+	size_t count = 0;
+	uint64_t total = 0;
+	uint64_t firstTime = 0;
+	auto start = steady_clock::now();
+
+	InputRecordEvent record;
+
+	while(mFile.read(reinterpret_cast<char*>(&record), sizeof(record)))
+	{
+		if (!total && !count)
+		{
+			firstTime = record.time;
+		}
+
+		auto due = start + microseconds(record.time - firstTime);
+
+		// dispatch pending events before waiting for the next one
+
+		if (count == cDispatchEvents || (!mFast && count &&
+			steady_clock::now() < due))
+		{
+			dispatch(events, count);
+
+			total += count;
+			count = 0;
+		}
+
+		{
+			unique_lock<mutex> lock(mMutex);
+
+			if (!mFast)
+			{
+				mCondVar.wait_until(lock, due, [this] { return mTerminate; });
+			}
+
+			if (mTerminate)
+			{
+				return;
+			}
+		}
+
+		auto now = LatencyHistogram::now();
+
+		events[count] = {};
+		events[count].input_event_sec = now / 1000000;
+		events[count].input_event_usec = now % 1000000;
+		events[count].type = record.type;
+		events[count].code = record.code;
+		events[count].value = record.value;
+
+		count++;
+	}
+
+	dispatch(events, count);
+
+	total += count;
+
+	LOG(mLog, DEBUG) << "Replay finished: " << mName
+					 << ", events: " << total << ", time: "
+					 << duration_cast<microseconds>(
+							steady_clock::now() - start).count() << " us";
+}
@@ -0,0 +1,136 @@
+/*
+ *  Input record and replay
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUT_INPUTRECORD_HPP_
+#define SRC_INPUT_INPUTRECORD_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <linux/input.h>
+
+#include <xen/be/Log.hpp>
+
+#include "InputSource.hpp"
+
+/*
+ * Record file format, all fields are in host byte order:
+ *
+ * header: magic (uint32_t) | version (uint32_t)
+ * event:  time in us (uint64_t) | type (uint16_t) | code (uint16_t) |
+ *         value (int32_t)
+ */
+
+struct InputRecordHeader
+{
+	static const uint32_t cMagic = 0x43524958; // XIRC
+	static const uint32_t cVersion = 1;
+
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct InputRecordEvent
+{
+	uint64_t time;
+	uint16_t type;
+	uint16_t code;
+	int32_t value;
+};
+
+/***************************************************************************//**
+ * Records evdev events to a file.
+ * @ingroup input_be
+ ******************************************************************************/
+class InputRecorder
+{
+public:
+
+	/**
+	 * @param fileName record file name
+	 */
+	InputRecorder(const std::string& fileName);
+	~InputRecorder();
+
+	/**
+	 * Writes events to the file
+	 * @param events events
+	 * @param count  number of events
+	 */
+	void write(const input_event* events, size_t count);
+
+private:
+
+	std::string mFileName;
+	std::ofstream mFile;
+	uint64_t mCount;
+
+	XenBackend::Log mLog;
+};
+
+/***************************************************************************//**
+ * Replays a record file as an evdev device.
+ * DevInput is created with id replay:<file> to replay the events with their
+ * original timing or replay-fast:<file> to replay them as fast as possible.
+ * Replaying starts when the first listener is added. Replayed events are
+ * timestamped with the dispatch time.
+ * @ingroup input_be
+ ******************************************************************************/
+class InputReplay : public InputSource
+{
+public:
+
+	/**
+	 * @param name replay id
+	 */
+	InputReplay(const std::string& name);
+	~InputReplay();
+
+	void addListener(DevInputBase* listener) override;
+
+	/**
+	 * Checks if the input id specifies a record file
+	 * @param name input id
+	 */
+	static bool isReplay(const std::string& name);
+
+private:
+
+	constexpr static const char* cPrefix = "replay:";
+	constexpr static const char* cFastPrefix = "replay-fast:";
+	static const int cDispatchEvents = 64;
+
+	std::ifstream mFile;
+	bool mFast;
+	bool mTerminate;
+
+	std::mutex mMutex;
+	std::condition_variable mCondVar;
+	std::thread mThread;
+
+	void run();
+	void replay();
+};
+
+#endif /* SRC_INPUT_INPUTRECORD_HPP_ */
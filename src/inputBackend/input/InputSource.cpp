@@ -0,0 +1,163 @@
+/*
+ *  Evdev event source
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "InputSource.hpp"
+
+#include <algorithm>
+
+#include "DevInput.hpp"
+#include "InputFocus.hpp"
+
+using std::find;
+using std::find_if;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::vector;
+
+/*******************************************************************************
+ * InputSource
+ ******************************************************************************/
+
+InputSource::InputSource(const string& name) :
+	mName(name),
+	mLog("InputSource"),
+	mFocus(InputFocus::cNoFocus),
+	mIsShared(false),
+	mIsFrameEnd(true)
+{
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+void InputSource::addListener(DevInputBase* listener)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	if (find(mListeners.begin(), mListeners.end(), listener) ==
+		mListeners.end())
+	{
+		mListeners.push_back(listener);
+
+		InputFocus::getInstance().addDomain(listener->mDomId);
+
+		updateShared();
+	}
+
+	LOG(mLog, DEBUG) << "Add listener: " << mName
+					 << ", listeners: " << mListeners.size();
+}
+
+void InputSource::removeListener(DevInputBase* listener)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	auto it = find(mListeners.begin(), mListeners.end(), listener);
+
+	if (it != mListeners.end())
+	{
+		mListeners.erase(it);
+
+		InputFocus::getInstance().removeDomain(listener->mDomId);
+
+		updateShared();
+	}
+
+	LOG(mLog, DEBUG) << "Remove listener: " << mName
+					 << ", listeners: " << mListeners.size();
+}
+
+/*******************************************************************************
+ * Protected
+ ******************************************************************************/
+
+void InputSource::dispatch(const input_event* events, size_t count)
+{
+	lock_guard<mutex> lock(mMutex);
+
+	if (mIsShared && mIsFrameEnd)
+	{
+		updateFocus();
+	}
+
+	for (auto listener : mListeners)
+	{
+		if (mIsShared && listener->mDomId != mFocus)
+		{
+			continue;
+		}
+
+		for(size_t i = 0; i < count; i++)
+		{
+			listener->onEvent(events[i]);
+		}
+	}
+
+	mIsFrameEnd = count && events[count - 1].type == EV_SYN &&
+				  events[count - 1].code == SYN_REPORT;
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+void InputSource::updateShared()
+{
+	mIsShared = find_if(mListeners.begin(), mListeners.end(),
+						[this](DevInputBase* listener)
+						{
+							return listener->mDomId !=
+								   mListeners.front()->mDomId;
+						}) != mListeners.end();
+}
+
+void InputSource::updateFocus()
+{
+	auto focus = InputFocus::getInstance().getFocus();
+
+	if (focus == mFocus)
+	{
+		return;
+	}
+
+	vector<input_event> events;
+
+	getReleaseEvents(events);
+
+	LOG(mLog, DEBUG) << "Switch focus: " << mName << ", dom id: " << focus
+					 << ", release events: " << events.size();
+
+	for (auto listener : mListeners)
+	{
+		if (listener->mDomId != mFocus)
+		{
+			continue;
+		}
+
+		for (auto& event : events)
+		{
+			listener->onEvent(event);
+		}
+	}
+
+	mFocus = focus;
+}
@@ -0,0 +1,121 @@
+/*
+ *  Evdev event source
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUT_INPUTSOURCE_HPP_
+#define SRC_INPUT_INPUTSOURCE_HPP_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <linux/input.h>
+
+#include <xen/be/Log.hpp>
+
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+class DevInputBase;
+
+/***************************************************************************//**
+ * Source of evdev events.
+ * Dispatches events to all DevInputBase instances listening to it. If the
+ * listeners belong to several domains, events are dispatched to listeners of
+ * the domain which has InputFocus only. The focus is followed at frame
+ * boundaries: the previously focused domain gets release events of pressed
+ * keys and touches, so they don't stay pressed there.
+ * @ingroup input_be
+ ******************************************************************************/
+class InputSource
+{
+public:
+
+	/**
+	 * @param name source name
+	 */
+	InputSource(const std::string& name);
+	virtual ~InputSource() {}
+
+	/**
+	 * Starts dispatching events to the listener
+	 */
+	virtual void addListener(DevInputBase* listener);
+
+	/**
+	 * Stops dispatching events to the listener. When it returns, the listener
+	 * is not called anymore.
+	 */
+	void removeListener(DevInputBase* listener);
+
+	/**
+	 * Returns source name
+	 */
+	const std::string& getName() const { return mName; }
+
+	/**
+	 * Gets absolute axis info
+	 * @param code axis code
+	 * @param info axis info
+	 * @return false if the source has no info for the axis
+	 */
+	virtual bool getAbsInfo(uint16_t code, input_absinfo& info)
+	{
+		return false;
+	}
+
+protected:
+
+	/**
+	 * Gets events which release pressed keys and touches
+	 * @param events events
+	 */
+	virtual void getReleaseEvents(std::vector<input_event>& events) {}
+
+	std::string mName;
+	XenBackend::Log mLog;
+
+	/**
+	 * Dispatches events to all listeners
+	 * @param events events
+	 * @param count  number of events
+	 */
+	void dispatch(const input_event* events, size_t count);
+
+private:
+
+	// domain which gets events if the listeners are shared
+	int mFocus;
+	bool mIsShared;
+	bool mIsFrameEnd;
+
+	std::mutex mMutex;
+	std::list<DevInputBase*> mListeners;
+
+	void updateShared();
+	void updateFocus();
+};
+
+typedef std::shared_ptr<InputSource> InputSourcePtr;
+
+#endif /* SRC_INPUT_INPUTSOURCE_HPP_ */
@@ -0,0 +1,193 @@
+/*
+ *  Udev monitor
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#include "UdevMonitor.hpp"
+
+#include <memory>
+
+#include <xen/be/Exception.hpp>
+
+using std::string;
+using std::unique_ptr;
+
+/*******************************************************************************
+ * UdevMonitor
+ ******************************************************************************/
+
+UdevMonitor::UdevMonitor() :
+	mUdev(nullptr),
+	mMonitor(nullptr),
+	mLog("UdevMonitor")
+{
+	try
+	{
+		init();
+	}
+	catch(const std::exception& e)
+	{
+		release();
+
+		throw;
+	}
+}
+
+UdevMonitor::~UdevMonitor()
+{
+	release();
+}
+
+/*******************************************************************************
+ * Public
+ ******************************************************************************/
+
+int UdevMonitor::getFd() const
+{
+	return udev_monitor_get_fd(mMonitor);
+}
+
+bool UdevMonitor::readAdded(string& devNode)
+{
+	unique_ptr<udev_device, decltype(&udev_device_unref)>
+			device(udev_monitor_receive_device(mMonitor), udev_device_unref);
+
+	if (!device || !isEvdev(device.get()))
+	{
+		return false;
+	}
+
+	auto action = udev_device_get_action(device.get());
+
+	DLOG(mLog, DEBUG) << "Udev event: " << (action ? action : "")
+					  << ", node: " << udev_device_get_devnode(device.get());
+
+	if (!action || string(action) != "add")
+	{
+		return false;
+	}
+
+	devNode = udev_device_get_devnode(device.get());
+
+	return true;
+}
+
+string UdevMonitor::findDevice(const string& vendorId, const string& productId)
+{
+	unique_ptr<udev, decltype(&udev_unref)> context(udev_new(), udev_unref);
+
+	if (!context)
+	{
+		return "";
+	}
+
+	unique_ptr<udev_enumerate, decltype(&udev_enumerate_unref)>
+			enumerate(udev_enumerate_new(context.get()), udev_enumerate_unref);
+
+	// property matches are ORed by udev, so the product is checked below
+
+	if (!enumerate ||
+		udev_enumerate_add_match_subsystem(enumerate.get(), "input") ||
+		udev_enumerate_add_match_property(enumerate.get(), "ID_VENDOR_ID",
+										  vendorId.c_str()) ||
+		udev_enumerate_scan_devices(enumerate.get()))
+	{
+		return "";
+	}
+
+	udev_list_entry* entry;
+
+	udev_list_entry_foreach(entry,
+							udev_enumerate_get_list_entry(enumerate.get()))
+	{
+		unique_ptr<udev_device, decltype(&udev_device_unref)>
+				device(udev_device_new_from_syspath(
+						context.get(), udev_list_entry_get_name(entry)),
+					   udev_device_unref);
+
+		if (!device || !isEvdev(device.get()))
+		{
+			continue;
+		}
+
+		auto model = udev_device_get_property_value(device.get(),
+													"ID_MODEL_ID");
+
+		if (model && productId == model)
+		{
+			return udev_device_get_devnode(device.get());
+		}
+	}
+
+	return "";
+}
+
+/*******************************************************************************
+ * Private
+ ******************************************************************************/
+
+bool UdevMonitor::isEvdev(udev_device* device)
+{
+	auto devNode = udev_device_get_devnode(device);
+
+	return devNode && string(devNode).compare(0, 16, "/dev/input/event") == 0;
+}
+
+void UdevMonitor::init()
+{
+	mUdev = udev_new();
+
+	if (!mUdev)
+	{
+		throw XenBackend::Exception("Can't create udev context", errno);
+	}
+
+	// udev source reports devices when their rules are applied, so by-id and
+	// by-path links are already created
+
+	mMonitor = udev_monitor_new_from_netlink(mUdev, "udev");
+
+	if (!mMonitor)
+	{
+		throw XenBackend::Exception("Can't create udev monitor", errno);
+	}
+
+	if (udev_monitor_filter_add_match_subsystem_devtype(mMonitor, "input",
+														nullptr) ||
+		udev_monitor_enable_receiving(mMonitor))
+	{
+		throw XenBackend::Exception("Can't enable udev monitor", errno);
+	}
+
+	LOG(mLog, DEBUG) << "Create";
+}
+
+void UdevMonitor::release()
+{
+	if (mMonitor)
+	{
+		udev_monitor_unref(mMonitor);
+	}
+
+	if (mUdev)
+	{
+		udev_unref(mUdev);
+
+		LOG(mLog, DEBUG) << "Delete";
+	}
+}
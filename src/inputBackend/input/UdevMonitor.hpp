@@ -0,0 +1,77 @@
+/*
+ *  Udev monitor
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Copyright (C) 2020 EPAM Systems Inc.
+ */
+
+#ifndef SRC_INPUT_UDEVMONITOR_HPP_
+#define SRC_INPUT_UDEVMONITOR_HPP_
+
+#include <string>
+
+#include <libudev.h>
+
+#include <xen/be/Log.hpp>
+
+/***************************************************************************//**
+ * Udev monitor of evdev devices.
+ * Reports evdev nodes added to the system and finds evdev nodes by vendor and
+ * product ids. As udev context is not thread safe, the search uses its own
+ * context.
+ * @ingroup input_be
+ ******************************************************************************/
+class UdevMonitor
+{
+public:
+
+	UdevMonitor();
+	~UdevMonitor();
+
+	/**
+	 * Returns fd which is readable when udev events are pending
+	 */
+	int getFd() const;
+
+	/**
+	 * Reads pending udev event
+	 * @param devNode node of the added evdev device
+	 * @return true if an evdev device is added
+	 */
+	bool readAdded(std::string& devNode);
+
+	/**
+	 * Finds node of the evdev device with given ids
+	 * @param vendorId  vendor id as in ID_VENDOR_ID udev property
+	 * @param productId product id as in ID_MODEL_ID udev property
+	 * @return device node, empty if the device is not found
+	 */
+	static std::string findDevice(const std::string& vendorId,
+								  const std::string& productId);
+
+private:
+
+	udev* mUdev;
+	udev_monitor* mMonitor;
+	XenBackend::Log mLog;
+
+	static bool isEvdev(udev_device* device);
+
+	void init();
+	void release();
+};
+
+#endif /* SRC_INPUT_UDEVMONITOR_HPP_ */
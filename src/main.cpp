@@ -25,6 +25,7 @@
 #include <iostream>
 #include <thread>
 
+#include <cstdio>
 #include <csignal>
 #include <execinfo.h>
 #include <getopt.h>
@@ -40,10 +41,14 @@
 #ifdef WITH_WAYLAND
 #include "wayland/Display.hpp"
 #endif //WITH_WAYLAND
+#include "LazyGnttabBuffer.hpp"
 #endif //WITH_DISPLAY
 
 #ifdef WITH_INPUT
 #include "InputBackend.hpp"
+#include "InputLatency.hpp"
+#include "input/InputFocus.hpp"
+#include "input/InputReactor.hpp"
 #endif
 
 #ifdef WITH_MOCKBELIB
@@ -104,6 +109,16 @@ void registerSignals()
 	act.sa_flags = SA_RESETHAND;
 
 	sigaction(SIGSEGV, &act, nullptr);
+
+	// block SIGUSR1 and SIGUSR2 before any thread is created: they are
+	// handled by sigwait
+
+	sigset_t set;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGUSR1);
+	sigaddset(&set, SIGUSR2);
+	sigprocmask(SIG_BLOCK, &set, nullptr);
 }
 
 void waitSignals()
@@ -114,10 +129,33 @@ void waitSignals()
 	sigemptyset(&set);
 	sigaddset(&set, SIGINT);
 	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGUSR1);
+	sigaddset(&set, SIGUSR2);
 	sigprocmask(SIG_BLOCK, &set, nullptr);
 
 	sigwait(&set,&signal);
 
+	while (signal == SIGUSR1 || signal == SIGUSR2)
+	{
+		if (signal == SIGUSR1)
+		{
+#ifdef WITH_DISPLAY
+			BuffersStorage::dumpStats();
+#endif
+#ifdef WITH_INPUT
+			InputLatency::getInstance().dump();
+#endif
+		}
+#ifdef WITH_INPUT
+		else
+		{
+			InputFocus::getInstance().switchNext();
+		}
+#endif
+
+		sigwait(&set,&signal);
+	}
+
 	if (signal == SIGTERM)
 	{
 		gRetStatus = EXIT_FAILURE;
@@ -128,9 +166,9 @@ bool commandLineOptions(int argc, char *argv[])
 {
 	int opt = -1;
 #ifdef WITH_ZCOPY
-	static const char* optString = "m:d:v:l:fhz?";
+	static const char* optString = "m:d:v:l:g:q:r:fhz?";
 #else
-	static const char* optString = "m:d:v:l:fh?";
+	static const char* optString = "m:d:v:l:g:q:r:fh?";
 #endif
 
 	while((opt = getopt(argc, argv, optString)) != -1)
@@ -187,6 +225,47 @@ bool commandLineOptions(int argc, char *argv[])
 
 			break;
 
+#ifdef WITH_DISPLAY
+		case 'g':
+		{
+			size_t limit;
+
+			if (sscanf(optarg, "%zu", &limit) != 1)
+			{
+				return false;
+			}
+
+			GnttabMapCache::getInstance().setDomainLimit(limit * 1024 * 1024);
+
+			break;
+		}
+
+		case 'q':
+		{
+			BuffersStorage::Quota limits {};
+
+			if (sscanf(optarg, "%zu,%zu,%zu", &limits.dumbBytes,
+					   &limits.grantPages, &limits.frameBuffers) != 3)
+			{
+				return false;
+			}
+
+			limits.dumbBytes *= 1024 * 1024;
+
+			BuffersStorage::setLimits(limits);
+
+			break;
+		}
+#endif
+
+#ifdef WITH_INPUT
+		case 'r':
+
+			EvdevDevice::setRecordDir(optarg);
+
+			break;
+#endif
+
 #ifdef WITH_ZCOPY
 		case 'z':
 
@@ -289,6 +368,16 @@ int main(int argc, char *argv[])
 			cout << "\t-z -- disable zero-copy" << endl;
 #endif
 			cout << "\t-d -- DRM device" << endl;
+#ifdef WITH_DISPLAY
+			cout << "\t-g -- limit of mapped guest buffers per domain, MiB"
+				 << endl;
+			cout << "\t-q -- per domain quota in format: "
+				 << "<dumb MiB>,<grant pages>,<frame buffers>, 0 - no limit"
+				 << endl;
+#endif
+#ifdef WITH_INPUT
+			cout << "\t-r -- directory to record input devices" << endl;
+#endif
 			cout << "\t-l -- log file" << endl;
 			cout << "\t-v -- verbose level in format: "
 				 << "<module>:<level>;<module:<level>" << endl;